@@ -0,0 +1,67 @@
+#include "bot.h"
+
+static float BotNextPressDelay(Bot* bot)
+{
+  // +-25% so presses don't all land on the same tick
+  return bot->params.reactionTime * (0.75f + CsimonRngFloat(&bot->rng) * 0.5f);
+}
+
+void BotInit(Bot* bot, BotParams params, uint64_t seed)
+{
+  bot->params = params;
+  CsimonRngSeed(&bot->rng, seed);
+  bot->pressDelay = BotNextPressDelay(bot);
+}
+
+static bool BotRemembers(Bot* bot, const CsimonGame* game)
+{
+  if (game->playerSequenceIndex >= bot->params.memorySpan)
+    return false;
+
+  // Buttons lit for less than about half the reaction time might not have been seen properly
+  float litTime = (float)CsimonSequenceLitTime(game) / (float)CSIMON_US_PER_SECOND;
+  float perceptionTime = bot->params.reactionTime * 0.5f;
+  if (litTime < perceptionTime &&
+      CsimonRngFloat(&bot->rng) > litTime / perceptionTime)
+    return false;
+
+  return true;
+}
+
+CsimonInput BotThink(Bot* bot, const CsimonGame* game, float dt)
+{
+  CsimonInput input = CsimonEmptyInput();
+
+  if (game->gameState == GAMESTATE_MENU || game->gameState == GAMESTATE_MENU_GAMEOVER)
+  {
+    input.startDown = true;
+    return input;
+  }
+
+  if (game->gameState != GAMESTATE_GAME || game->isShowingSequence || game->isShowingButtonAnimation)
+  {
+    bot->pressDelay = BotNextPressDelay(bot);
+    return input;
+  }
+
+  bot->pressDelay -= dt;
+  if (bot->pressDelay > 0.f)
+    return input;
+  bot->pressDelay = BotNextPressDelay(bot);
+
+  int button = CsimonSequenceButton(game, game->playerSequenceIndex);
+  if (!BotRemembers(bot, game))
+  {
+    // A forgotten step is a guess, which is sometimes right anyway
+    button = CsimonRngButton(&bot->rng);
+  }
+  if (CsimonRngFloat(&bot->rng) < bot->params.errorRate)
+  {
+    // Fat fingered, always one of the other three
+    button = (button + 1 + (int)CsimonRngRange(&bot->rng, BUTTON_AMOUNT - 1)) % BUTTON_AMOUNT;
+  }
+
+  input.buttonPressed = button;
+  input.buttonsDown[button] = true;
+  return input;
+}
@@ -0,0 +1,26 @@
+#ifndef CSIMON_BOT_H
+#define CSIMON_BOT_H
+
+#include <stdint.h>
+
+#include "game.h"
+#include "rng.h"
+
+// Pretend player used for balancing, no raylib needed
+typedef struct BotParams {
+  float reactionTime; // Seconds between presses, also how long a lit button takes to register
+  int memorySpan;     // Steps it can remember, anything past this is a guess
+  float errorRate;    // Chance of fat fingering any single press
+} BotParams;
+
+typedef struct Bot {
+  BotParams params;
+  CsimonRng rng;
+  float pressDelay;
+} Bot;
+
+void BotInit(Bot* bot, BotParams params, uint64_t seed);
+// Works out what the bot does this tick
+CsimonInput BotThink(Bot* bot, const CsimonGame* game, float dt);
+
+#endif
@@ -3,11 +3,16 @@
 mkdir -p build/linux
 mkdir -p build/windows
 mkdir -p build/web
+mkdir -p build/tools
 
+echo "Building target [res]"
+./build_res.sh > /dev/null
 echo "Building target [linux]"
 ./build_linux.sh > /dev/null
 echo "Building target [windows]"
 ./build_windows.sh > /dev/null
 echo "Building target [web]"
 ./build_web.sh > /dev/null
+echo "Building target [tools]"
+./build_tools.sh > /dev/null
 echo "Finished."
@@ -1,3 +1,4 @@
 #!/bin/sh
 
-gcc main.c -o build/linux/csimon -L./libs/linux/rl -I./libs/linux/rl/include -lraylib -ldl -lrt -lm -lpthread
+# The raylib in libs/ is the GLFW desktop build, power save waits on events through its GLFW
+gcc main.c game.c rng.c bot.c replay.c save.c stats.c leaderboard.c input.c inputthread.c latency.c tween.c font.c circle.c -DPLATFORM_DESKTOP_GLFW -o build/linux/csimon -L./libs/linux/rl -I./libs/linux/rl/include -lraylib -ldl -lrt -lm -lpthread
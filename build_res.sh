@@ -0,0 +1,5 @@
+#!/bin/sh
+
+# Generated resources, everything else includes these so they go first
+gcc tools/bake_font.c -o build/tools/csimon-bake-font -I. -I./libs/linux/rl/include -L./libs/linux/rl -lraylib -ldl -lrt -lm -lpthread
+./build/tools/csimon-bake-font res/font_atlas.h
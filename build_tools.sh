@@ -0,0 +1,4 @@
+#!/bin/sh
+
+gcc -O2 tools/balance.c game.c rng.c bot.c -o build/tools/csimon-balance -I. -lm -lpthread
+gcc -O2 tools/soak.c game.c rng.c bot.c -o build/tools/csimon-soak -I. -lm
@@ -1,3 +1,3 @@
 #!/bin/sh
 
-emcc main.c -o build/web/csimon.html -L./libs/web/rl -I./libs/web/rl/include -lraylib -s ALLOW_MEMORY_GROWTH=1 -s WASM=1 -s USE_GLFW=3 -s ASYNCIFY -s SINGLE_FILE=1
+emcc main.c game.c rng.c bot.c replay.c save.c stats.c leaderboard.c input.c inputthread.c latency.c tween.c font.c circle.c -o build/web/csimon.html -L./libs/web/rl -I./libs/web/rl/include -lraylib -s ALLOW_MEMORY_GROWTH=1 -s WASM=1 -s USE_GLFW=3 -s ASYNCIFY -s SINGLE_FILE=1
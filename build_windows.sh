@@ -1,3 +1,4 @@
 #!/bin/sh
 
-x86_64-w64-mingw32-gcc main.c -o build/windows/csimon.exe -L./libs/windows/rl -I./libs/windows/rl/include -lm -lpthread -lraylib -lgdi32 -lwinmm
+# The raylib in libs/ is the GLFW desktop build, power save waits on events through its GLFW
+x86_64-w64-mingw32-gcc main.c game.c rng.c bot.c replay.c save.c stats.c leaderboard.c input.c inputthread.c latency.c tween.c font.c circle.c -DPLATFORM_DESKTOP_GLFW -o build/windows/csimon.exe -L./libs/windows/rl -I./libs/windows/rl/include -lm -lpthread -lraylib -lgdi32 -lwinmm
@@ -0,0 +1,243 @@
+#include "circle.h"
+
+#include <stddef.h>
+#include <rlgl.h>
+#define RAYMATH_STATIC_INLINE
+#include <raymath.h>
+
+typedef struct CircleInstance {
+  float x;
+  float y;
+  float radius;
+  float glow;
+  unsigned char color[4];
+} CircleInstance;
+
+static CircleInstance instances[CIRCLE_BATCH_MAX];
+static int instanceCount = 0;
+
+// One quad per circle, corners from -1 to 1 scaled out to cover the circle and its glow.
+// Everything is in pixels so the edge fades over exactly one of them
+static const char* INSTANCED_VERTEX_SHADER =
+  "#version 330\n"
+  "in vec2 vertexPosition;\n"
+  "in vec4 instanceCircle;\n" // x, y, radius, glow
+  "in vec4 instanceColor;\n"
+  "uniform mat4 mvp;\n"
+  "out vec2 fragOffset;\n"
+  "flat out vec2 fragShape;\n"
+  "out vec4 fragColor;\n"
+  "void main()\n"
+  "{\n"
+  "  float extent = instanceCircle.z + instanceCircle.w + 1.0;\n"
+  "  fragOffset = vertexPosition*extent;\n"
+  "  fragShape = instanceCircle.zw;\n"
+  "  fragColor = instanceColor;\n"
+  "  gl_Position = mvp*vec4(instanceCircle.xy + fragOffset, 0.0, 1.0);\n"
+  "}\n";
+
+static const char* INSTANCED_FRAGMENT_SHADER =
+  "#version 330\n"
+  "in vec2 fragOffset;\n"
+  "flat in vec2 fragShape;\n"
+  "in vec4 fragColor;\n"
+  "out vec4 finalColor;\n"
+  "void main()\n"
+  "{\n"
+  "  float distance = length(fragOffset);\n"
+  "  float coverage = clamp(fragShape.x - distance + 0.5, 0.0, 1.0);\n"
+  "  float glow = 0.0;\n"
+  "  if (fragShape.y > 0.0)\n"
+  "  {\n"
+  "    float fade = 1.0 - clamp((distance - fragShape.x)/fragShape.y, 0.0, 1.0);\n"
+  "    glow = 0.5*fade*fade;\n"
+  "  }\n"
+  "  finalColor = vec4(fragColor.rgb, fragColor.a*max(coverage, glow));\n"
+  "}\n";
+
+// Fallback, distance from the middle of the quad in texture coordinates with the edge
+// at 0.5, faded out over however much of that one pixel covers
+#ifdef __EMSCRIPTEN__
+static const char* QUAD_SHADER =
+  "#version 100\n"
+  "#extension GL_OES_standard_derivatives : enable\n"
+  "precision mediump float;\n"
+  "varying vec2 fragTexCoord;\n"
+  "varying vec4 fragColor;\n"
+  "uniform vec4 colDiffuse;\n"
+  "void main()\n"
+  "{\n"
+  "  float distance = length(fragTexCoord - vec2(0.5));\n"
+  "  float width = fwidth(distance);\n"
+  "  float alpha = 1.0 - smoothstep(0.5 - width, 0.5, distance);\n"
+  "  gl_FragColor = vec4(fragColor.rgb, fragColor.a*alpha)*colDiffuse;\n"
+  "}\n";
+#else
+static const char* QUAD_SHADER =
+  "#version 330\n"
+  "in vec2 fragTexCoord;\n"
+  "in vec4 fragColor;\n"
+  "uniform vec4 colDiffuse;\n"
+  "out vec4 finalColor;\n"
+  "void main()\n"
+  "{\n"
+  "  float distance = length(fragTexCoord - vec2(0.5));\n"
+  "  float width = fwidth(distance);\n"
+  "  float alpha = 1.0 - smoothstep(0.5 - width, 0.5, distance);\n"
+  "  finalColor = vec4(fragColor.rgb, fragColor.a*alpha)*colDiffuse;\n"
+  "}\n";
+#endif
+
+static bool useInstancing = false;
+static unsigned int instancedShader = 0;
+static int mvpLocation = -1;
+static unsigned int vao = 0;
+static unsigned int cornerBuffer = 0;
+static unsigned int instanceBuffer = 0;
+
+static bool useQuadShader = false;
+static Shader quadShader;
+static Texture2D whiteTexture; // Just so the fallback quads get 0-1 texture coordinates
+
+static bool LoadInstancing(void)
+{
+  int version = rlGetVersion();
+  if (version != RL_OPENGL_33 && version != RL_OPENGL_43)
+    return false;
+
+  instancedShader = rlLoadShaderCode(INSTANCED_VERTEX_SHADER, INSTANCED_FRAGMENT_SHADER);
+  if (instancedShader == 0 || instancedShader == rlGetShaderIdDefault())
+    return false;
+
+  int cornerLocation = rlGetLocationAttrib(instancedShader, "vertexPosition");
+  int circleLocation = rlGetLocationAttrib(instancedShader, "instanceCircle");
+  int colorLocation = rlGetLocationAttrib(instancedShader, "instanceColor");
+  mvpLocation = rlGetLocationUniform(instancedShader, "mvp");
+  if (cornerLocation < 0 || circleLocation < 0 || colorLocation < 0 || mvpLocation < 0)
+  {
+    rlUnloadShaderProgram(instancedShader);
+    return false;
+  }
+
+  static const float corners[] = {
+    -1.f, -1.f,  1.f, -1.f,  1.f, 1.f,
+    -1.f, -1.f,  1.f,  1.f, -1.f, 1.f
+  };
+
+  vao = rlLoadVertexArray();
+  rlEnableVertexArray(vao);
+
+  cornerBuffer = rlLoadVertexBuffer(corners, sizeof(corners), false);
+  rlSetVertexAttribute(cornerLocation, 2, RL_FLOAT, false, 0, 0);
+  rlEnableVertexAttribute(cornerLocation);
+
+  instanceBuffer = rlLoadVertexBuffer(instances, sizeof(instances), true);
+  rlSetVertexAttribute(circleLocation, 4, RL_FLOAT, false, sizeof(CircleInstance), offsetof(CircleInstance, x));
+  rlEnableVertexAttribute(circleLocation);
+  rlSetVertexAttributeDivisor(circleLocation, 1);
+  rlSetVertexAttribute(colorLocation, 4, RL_UNSIGNED_BYTE, true, sizeof(CircleInstance), offsetof(CircleInstance, color));
+  rlEnableVertexAttribute(colorLocation);
+  rlSetVertexAttributeDivisor(colorLocation, 1);
+
+  rlDisableVertexArray();
+  rlDisableVertexBuffer();
+  return true;
+}
+
+void LoadCircleRenderer(void)
+{
+  useInstancing = LoadInstancing();
+  if (useInstancing)
+    return;
+
+  TraceLog(LOG_INFO, "No instancing, drawing circles one at a time");
+  quadShader = LoadShaderFromMemory(NULL, QUAD_SHADER);
+  useQuadShader = quadShader.id != rlGetShaderIdDefault();
+  if (!useQuadShader)
+    TraceLog(LOG_WARNING, "Circle shader didn't compile, circles won't be antialiased");
+
+  Image white = GenImageColor(1, 1, WHITE);
+  whiteTexture = LoadTextureFromImage(white);
+  UnloadImage(white);
+}
+
+void UnloadCircleRenderer(void)
+{
+  if (useInstancing)
+  {
+    rlUnloadVertexArray(vao);
+    rlUnloadVertexBuffer(cornerBuffer);
+    rlUnloadVertexBuffer(instanceBuffer);
+    rlUnloadShaderProgram(instancedShader);
+    return;
+  }
+
+  UnloadShader(quadShader);
+  UnloadTexture(whiteTexture);
+}
+
+void AddCircle(Vector2 center, float radius, float glow, Color color)
+{
+  if (instanceCount == CIRCLE_BATCH_MAX)
+    DrawCircleBatch();
+
+  CircleInstance* instance = &instances[instanceCount++];
+  instance->x = center.x;
+  instance->y = center.y;
+  instance->radius = radius;
+  instance->glow = glow;
+  instance->color[0] = color.r;
+  instance->color[1] = color.g;
+  instance->color[2] = color.b;
+  instance->color[3] = color.a;
+}
+
+static void DrawCircleQuads(void)
+{
+  if (useQuadShader) BeginShaderMode(quadShader);
+
+  for (int i = 0; i < instanceCount; i++)
+  {
+    const CircleInstance* instance = &instances[i];
+    Vector2 center = { instance->x, instance->y };
+    Color color = { instance->color[0], instance->color[1], instance->color[2], instance->color[3] };
+
+    if (!useQuadShader)
+    {
+      DrawCircleV(center, instance->radius, color);
+      continue;
+    }
+
+    Rectangle quad = { center.x - instance->radius, center.y - instance->radius, instance->radius * 2.f, instance->radius * 2.f };
+    DrawTexturePro(whiteTexture, (Rectangle){ 0.f, 0.f, 1.f, 1.f }, quad, (Vector2){ 0.f, 0.f }, 0.f, color);
+  }
+
+  if (useQuadShader) EndShaderMode();
+}
+
+void DrawCircleBatch(void)
+{
+  if (instanceCount == 0)
+    return;
+
+  if (!useInstancing)
+  {
+    DrawCircleQuads();
+    instanceCount = 0;
+    return;
+  }
+
+  // Whatever raylib has queued up so far has to go out first to keep the order
+  rlDrawRenderBatchActive();
+
+  rlUpdateVertexBuffer(instanceBuffer, instances, instanceCount * (int)sizeof(CircleInstance), 0);
+
+  rlEnableShader(instancedShader);
+  rlSetUniformMatrix(mvpLocation, MatrixMultiply(rlGetMatrixModelview(), rlGetMatrixProjection()));
+  rlEnableVertexArray(vao);
+  rlDrawVertexArrayInstanced(0, 6, instanceCount);
+  rlDisableVertexArray();
+  rlDisableShader();
+
+  instanceCount = 0;
+}
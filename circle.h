@@ -0,0 +1,22 @@
+#ifndef CSIMON_CIRCLE_H
+#define CSIMON_CIRCLE_H
+
+#include <raylib.h>
+
+// Circles (buttons, glows, effects) get queued up and drawn together in one instanced
+// draw, each one a quad with its edge antialiased in the fragment shader, so the
+// framebuffer doesn't need MSAA. Where instancing isn't there (WebGL 1) they're drawn
+// one quad at a time with the same antialiasing instead.
+
+#define CIRCLE_BATCH_MAX 256
+
+// Call after InitWindow
+void LoadCircleRenderer(void);
+void UnloadCircleRenderer(void);
+
+// glow is how far past the edge a soft halo of the same color reaches, 0 for none
+void AddCircle(Vector2 center, float radius, float glow, Color color);
+// Draws everything added since the last call, between BeginDrawing / EndDrawing
+void DrawCircleBatch(void);
+
+#endif
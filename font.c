@@ -0,0 +1,156 @@
+#include "font.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "res/font_atlas.h"
+
+// Distance is 0.5 on the glyph edge, antialiased over however many
+// texels one pixel covers at the size it's drawn
+#ifdef __EMSCRIPTEN__
+static const char* FONT_SHADER =
+  "#version 100\n"
+  "#extension GL_OES_standard_derivatives : enable\n"
+  "precision mediump float;\n"
+  "varying vec2 fragTexCoord;\n"
+  "varying vec4 fragColor;\n"
+  "uniform sampler2D texture0;\n"
+  "uniform vec4 colDiffuse;\n"
+  "void main()\n"
+  "{\n"
+  "  float distance = texture2D(texture0, fragTexCoord).a - 0.5;\n"
+  "  float width = length(vec2(dFdx(distance), dFdy(distance)));\n"
+  "  float alpha = smoothstep(-width, width, distance);\n"
+  "  gl_FragColor = vec4(fragColor.rgb, fragColor.a*alpha)*colDiffuse;\n"
+  "}\n";
+#else
+static const char* FONT_SHADER =
+  "#version 330\n"
+  "in vec2 fragTexCoord;\n"
+  "in vec4 fragColor;\n"
+  "uniform sampler2D texture0;\n"
+  "uniform vec4 colDiffuse;\n"
+  "out vec4 finalColor;\n"
+  "void main()\n"
+  "{\n"
+  "  float distance = texture(texture0, fragTexCoord).a - 0.5;\n"
+  "  float width = length(vec2(dFdx(distance), dFdy(distance)));\n"
+  "  float alpha = smoothstep(-width, width, distance);\n"
+  "  finalColor = vec4(fragColor.rgb, fragColor.a*alpha)*colDiffuse;\n"
+  "}\n";
+#endif
+
+Font LoadBakedFont(void)
+{
+  Font font = { 0 };
+
+  int pixelCount = 0;
+  unsigned char* alpha = DecompressData(FONT_ATLAS_DATA, sizeof(FONT_ATLAS_DATA), &pixelCount);
+  if (alpha == NULL || pixelCount != FONT_ATLAS_WIDTH * FONT_ATLAS_HEIGHT)
+  {
+    printf("Baked font atlas is corrupt\n");
+    MemFree(alpha);
+    return GetFontDefault();
+  }
+
+  // Same white + alpha layout raylib gives its own font atlases, so tinting works
+  unsigned char* pixels = MemAlloc(pixelCount * 2);
+  for (int i = 0; i < pixelCount; i++)
+  {
+    pixels[i*2] = 255;
+    pixels[i*2 + 1] = alpha[i];
+  }
+  MemFree(alpha);
+
+  Image atlas = { pixels, FONT_ATLAS_WIDTH, FONT_ATLAS_HEIGHT, 1, PIXELFORMAT_UNCOMPRESSED_GRAY_ALPHA };
+  font.texture = LoadTextureFromImage(atlas);
+  UnloadImage(atlas);
+
+  // Distances have to be interpolated between texels for the edge to come out smooth
+  SetTextureFilter(font.texture, TEXTURE_FILTER_BILINEAR);
+
+  font.baseSize = FONT_ATLAS_SIZE;
+  font.glyphCount = FONT_ATLAS_GLYPH_AMOUNT;
+  font.glyphPadding = FONT_ATLAS_PADDING;
+  font.glyphs = MemAlloc(FONT_ATLAS_GLYPH_AMOUNT * sizeof(GlyphInfo));
+  font.recs = MemAlloc(FONT_ATLAS_GLYPH_AMOUNT * sizeof(Rectangle));
+
+  for (int i = 0; i < FONT_ATLAS_GLYPH_AMOUNT; i++)
+  {
+    const BakedGlyph* glyph = &FONT_ATLAS_GLYPHS[i];
+    font.glyphs[i].value = glyph->codepoint;
+    font.glyphs[i].offsetX = glyph->offsetX;
+    font.glyphs[i].offsetY = glyph->offsetY;
+    font.glyphs[i].advanceX = glyph->advanceX;
+    font.glyphs[i].image = (Image){ 0 };
+    font.recs[i] = (Rectangle){ (float)glyph->x, (float)glyph->y, (float)glyph->width, (float)glyph->height };
+  }
+
+  return font;
+}
+
+Shader LoadBakedFontShader(void)
+{
+  return LoadShaderFromMemory(NULL, FONT_SHADER);
+}
+
+bool TextLayoutSet(TextLayout* layout, Font font, const char* text, float size, float spacing)
+{
+  if (layout->textureId == font.texture.id && layout->size == size && layout->spacing == spacing &&
+      strcmp(layout->text, text) == 0)
+    return false;
+
+  layout->textureId = font.texture.id;
+  layout->size = size;
+  layout->spacing = spacing;
+  snprintf(layout->text, sizeof(layout->text), "%s", text);
+
+  layout->texture = font.texture;
+  layout->glyphCount = 0;
+
+  // Same maths as DrawTextEx / MeasureTextEx, for one line
+  float scale = size / (float)font.baseSize;
+  float padding = (float)font.glyphPadding;
+  float x = 0.f;
+
+  for (const char* next = layout->text; *next != '\0';)
+  {
+    int codepointSize = 0;
+    int codepoint = GetCodepointNext(next, &codepointSize);
+    next += codepointSize;
+
+    int index = GetGlyphIndex(font, codepoint);
+    GlyphInfo glyph = font.glyphs[index];
+    Rectangle rec = font.recs[index];
+
+    if (codepoint != ' ' && codepoint != '\t')
+    {
+      layout->sources[layout->glyphCount] = (Rectangle){ rec.x - padding, rec.y - padding, rec.width + 2.f*padding, rec.height + 2.f*padding };
+      layout->quads[layout->glyphCount] = (Rectangle){
+        x + (glyph.offsetX - padding) * scale,
+        (glyph.offsetY - padding) * scale,
+        (rec.width + 2.f*padding) * scale,
+        (rec.height + 2.f*padding) * scale
+      };
+      layout->glyphCount++;
+    }
+
+    float advance = (glyph.advanceX != 0) ? (float)glyph.advanceX : rec.width + (float)glyph.offsetX;
+    x += advance * scale + spacing;
+  }
+
+  layout->dimensions.x = (layout->text[0] != '\0') ? x - spacing : 0.f;
+  layout->dimensions.y = size;
+  return true;
+}
+
+void DrawTextLayout(const TextLayout* layout, Vector2 position, Color tint)
+{
+  for (int i = 0; i < layout->glyphCount; i++)
+  {
+    Rectangle quad = layout->quads[i];
+    quad.x += position.x;
+    quad.y += position.y;
+    DrawTexturePro(layout->texture, layout->sources[i], quad, (Vector2){ 0.f, 0.f }, 0.f, tint);
+  }
+}
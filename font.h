@@ -0,0 +1,63 @@
+#ifndef CSIMON_FONT_H
+#define CSIMON_FONT_H
+
+#include <raylib.h>
+
+// The one font the game uses, baked at build time by tools/bake_font.c as a signed
+// distance field, so any size comes out sharp from the same texture as long as it's
+// drawn with the font shader
+
+#define FONT_ATLAS_SIZE 50
+// SDF glyphs already carry their own border, this just keeps neighbours from bleeding
+#define FONT_ATLAS_PADDING 2
+
+// Every string the game draws. The atlas only gets the characters in FONT_CHARACTERS,
+// so anything new that gets drawn has to be added there
+#define MENU_TITLE "PRESS START"
+#define GAMEOVER_TITLE "GAME OVER!"
+#define WIN_TITLE "YOU WIN!"
+#define AUTHOR "Made by flebedev77"
+#define SCORE_LABEL "Score: "
+#define BEST_LABEL "Best: "
+// Leaderboard rows are built from initials, scores and dates
+#define LEADERBOARD_CHARACTERS "ABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789.- "
+#define FONT_CHARACTERS MENU_TITLE GAMEOVER_TITLE WIN_TITLE AUTHOR SCORE_LABEL BEST_LABEL LEADERBOARD_CHARACTERS "0123456789/"
+
+typedef struct BakedGlyph {
+  int codepoint;
+  int offsetX;
+  int offsetY;
+  int advanceX;
+  int x;
+  int y;
+  int width;
+  int height;
+} BakedGlyph;
+
+#define TEXT_LAYOUT_MAX_LENGTH 64
+
+// Where each glyph of a string goes, worked out once and drawn as is every frame
+typedef struct TextLayout {
+  // What it was laid out for, setting the same again costs a strcmp
+  unsigned int textureId;
+  float size;
+  float spacing;
+  char text[TEXT_LAYOUT_MAX_LENGTH];
+
+  Texture2D texture;
+  Vector2 dimensions; // Same as MeasureTextEx
+  int glyphCount;
+  Rectangle sources[TEXT_LAYOUT_MAX_LENGTH];
+  Rectangle quads[TEXT_LAYOUT_MAX_LENGTH]; // Relative to where the text gets drawn
+} TextLayout;
+
+// Lays text out again only if anything differs from last time, true if it did
+bool TextLayoutSet(TextLayout* layout, Font font, const char* text, float size, float spacing);
+void DrawTextLayout(const TextLayout* layout, Vector2 position, Color tint);
+
+// Uploads the baked atlas, unload with UnloadFont like any other font
+Font LoadBakedFont(void);
+// Draw text from the baked font between BeginShaderMode / EndShaderMode with this
+Shader LoadBakedFontShader(void);
+
+#endif
@@ -0,0 +1,378 @@
+#include "game.h"
+
+#include <string.h>
+
+#define BUTTONS_PER_HASH 32
+
+int CsimonSequenceButton(const CsimonGame* game, int index)
+{
+  // Every hash gives 64 bits, so 32 two bit buttons
+  uint64_t bits = CsimonRngHash(game->sequenceSeed, (uint64_t)index / BUTTONS_PER_HASH);
+  return (int)((bits >> ((index % BUTTONS_PER_HASH) * 2)) & 3);
+}
+
+static void ResetButtons(CsimonGame* game)
+{
+  for (size_t i = 0; i < BUTTON_AMOUNT; i++)
+  {
+    game->buttonsLit[i] = false;
+  }
+}
+
+static void LightButtons(CsimonGame* game)
+{
+  for (size_t i = 0; i < BUTTON_AMOUNT; i++)
+  {
+    game->buttonsLit[i] = true;
+  }
+}
+
+// Ran whenever player messes up, etc.
+static void SoftReset(CsimonGame* game)
+{
+  game->playerSequenceIndex = 0;
+
+  game->isShowingSequence = true;
+  game->isShowingButtonAnimation = false;
+  game->sequenceDisplayIndex = 0;
+  game->sequenceTime = 0;
+
+  game->gameoverAnimationBlinkCount = 0;
+  game->gameoverBlinkAnimationState = 0;
+
+  game->gameStateWaitDuration = 0;
+  game->gameStateWaitTime = 0;
+
+  game->menuTime = 0;
+}
+
+static void SpeedUp(CsimonGame* game)
+{
+  if (game->sequenceDisplayRate > game->difficulty.minDisplayRate)
+  {
+    game->sequenceDisplayRate -= game->sequenceDisplayRateAcceleration;
+  }
+  if (game->sequenceDisplayRateAcceleration > 0.f)
+  {
+    game->sequenceDisplayRateAcceleration -= game->difficulty.displayRateAccelerationDecceleration;
+  }
+  if (game->sequenceDisplayRateAcceleration < 0.f)
+  {
+    game->sequenceDisplayRateAcceleration = 0.f;
+  }
+}
+
+void CsimonReset(CsimonGame* game)
+{
+  ResetButtons(game);
+
+  game->score = 0;
+
+  game->runTime = 0;
+
+  uint64_t seedHigh = CsimonRngNext(&game->rng);
+  uint64_t seedLow = CsimonRngNext(&game->rng);
+  game->sequenceSeed = (seedHigh << 32) | seedLow;
+  game->sequenceLength = 1;
+
+  game->playerSequenceIndex = 0;
+
+  SoftReset(game);
+
+  game->sequenceDisplayRate = game->difficulty.initialDisplayRate;
+  game->sequenceDisplayRateAcceleration = game->difficulty.displayRateAcceleration;
+
+  int startLength = game->startLength;
+  if (!game->marathon && startLength > SEQUENCE_CAPACITY) startLength = SEQUENCE_CAPACITY;
+
+  // Once the acceleration runs out nothing changes anymore, so skip straight to the end
+  while (game->sequenceLength < startLength && game->sequenceDisplayRateAcceleration > 0.f)
+  {
+    SpeedUp(game);
+    game->sequenceLength++;
+  }
+  game->sequenceLength = startLength;
+
+  game->gameState = GAMESTATE_MENU;
+  game->gameStateAfterWait = GAMESTATE_MENU;
+}
+
+CsimonDifficulty CsimonDefaultDifficulty(void)
+{
+  CsimonDifficulty difficulty;
+  difficulty.initialDisplayRate = INITIAL_SEQUENCE_DISPLAY_RATE;
+  difficulty.displayRateAcceleration = SEQUENCE_DISPLAY_RATE_ACCELERATION;
+  difficulty.displayRateAccelerationDecceleration = SEQUENCE_DISPLAY_RATE_ACCELERATION_DECCELERATION;
+  difficulty.minDisplayRate = MIN_SEQUENCE_DISPLAY_RATE;
+  return difficulty;
+}
+
+void CsimonSeed(CsimonGame* game, uint64_t seed)
+{
+  game->seed = seed;
+  CsimonRngSeed(&game->rng, seed);
+}
+
+void CsimonInit(CsimonGame* game)
+{
+  int highScore = game->highScore;
+  memset(game, 0, sizeof(*game));
+  game->highScore = highScore;
+  game->difficulty = CsimonDefaultDifficulty();
+  game->startLength = 1;
+  CsimonSeed(game, 0);
+
+  CsimonReset(game);
+}
+
+void CsimonSetStartLength(CsimonGame* game, int length)
+{
+  game->startLength = (length < 1) ? 1 : length;
+}
+
+CsimonInput CsimonEmptyInput(void)
+{
+  CsimonInput input = { 0 };
+  input.buttonPressed = -1;
+  return input;
+}
+
+uint64_t CsimonDtToUs(float dt)
+{
+  return (uint64_t)(dt * 1e6f + 0.5f);
+}
+
+// The gap before the first button is the same as how long each one stays lit
+uint64_t CsimonSequenceLitTime(const CsimonGame* game)
+{
+  return CsimonDtToUs(game->sequenceDisplayRate);
+}
+
+static uint64_t SequenceStepTime(const CsimonGame* game)
+{
+  uint64_t litTime = CsimonSequenceLitTime(game);
+  return litTime + litTime / OFF_TO_ON_SHOWING_SEQUENCE_RATIO;
+}
+
+int CsimonSequenceEdgeCount(const CsimonGame* game)
+{
+  return game->sequenceLength * 2;
+}
+
+CsimonSequenceEdge CsimonSequenceEdgeAt(const CsimonGame* game, int edge)
+{
+  int index = edge / 2;
+  uint64_t litTime = CsimonSequenceLitTime(game);
+  uint64_t stepEnd = litTime + (uint64_t)(index + 1) * SequenceStepTime(game);
+
+  CsimonSequenceEdge sequenceEdge;
+  sequenceEdge.button = CsimonSequenceButton(game, index);
+  sequenceEdge.lit = (edge % 2) == 0;
+  sequenceEdge.time = sequenceEdge.lit ? stepEnd - litTime : stepEnd;
+  return sequenceEdge;
+}
+
+uint64_t CsimonSequenceDuration(const CsimonGame* game)
+{
+  return CsimonSequenceLitTime(game) + (uint64_t)game->sequenceLength * SequenceStepTime(game);
+}
+
+int CsimonSequenceNextEdge(const CsimonGame* game)
+{
+  uint64_t litTime = CsimonSequenceLitTime(game);
+  if (game->sequenceTime < litTime)
+    return 0;
+
+  uint64_t stepTime = SequenceStepTime(game);
+  uint64_t sinceGap = game->sequenceTime - litTime;
+  uint64_t index = sinceGap / stepTime;
+  if (index >= (uint64_t)game->sequenceLength)
+    return CsimonSequenceEdgeCount(game);
+
+  // Still dark means the next edge is this step lighting up, otherwise it going off
+  bool lit = sinceGap % stepTime >= stepTime - litTime;
+  return (int)index * 2 + (lit ? 1 : 0);
+}
+
+static void StepSequence(CsimonGame* game, uint64_t dtUs)
+{
+  game->sequenceTime += dtUs;
+  ResetButtons(game);
+
+  if (game->sequenceTime >= CsimonSequenceDuration(game))
+  {
+    game->sequenceDisplayIndex = 0;
+    game->sequenceTime = 0;
+    game->playerSequenceIndex = 0;
+    game->isShowingSequence = false;
+    game->inputWaitTime = 0;
+    return;
+  }
+
+  // Straight from the clock, which step we're in and whether its button is lit yet
+  uint64_t litTime = CsimonSequenceLitTime(game);
+  if (game->sequenceTime < litTime)
+    return;
+
+  uint64_t stepTime = SequenceStepTime(game);
+  uint64_t sinceGap = game->sequenceTime - litTime;
+  int index = (int)(sinceGap / stepTime);
+  bool lit = sinceGap % stepTime >= stepTime - litTime;
+
+  if (lit)
+  {
+    game->buttonsLit[CsimonSequenceButton(game, index)] = true;
+  }
+  game->sequenceDisplayIndex = lit ? index + 1 : index;
+}
+
+static void EndRun(CsimonGame* game, int animationType)
+{
+  game->runsFinished++;
+  game->lastScore = game->score;
+  game->lastLength = game->sequenceLength;
+
+  CsimonReset(game);
+  game->gameState = GAMESTATE_WAITING;
+  game->gameStateAfterWait = GAMESTATE_MENU_GAMEOVER;
+  game->gameStateWaitDuration = GAMEOVER_WAIT_TIME;
+  game->isShowingButtonAnimation = true;
+  game->animationType = animationType;
+}
+
+static void StepPlayer(CsimonGame* game, int buttonPressed)
+{
+  if (buttonPressed == -1)
+    return;
+
+  game->lastReactionTime = game->inputWaitTime;
+  game->inputWaitTime = 0;
+  game->pressCount++;
+
+  if (buttonPressed == CsimonSequenceButton(game, game->playerSequenceIndex))
+  {
+    game->playerSequenceIndex++;
+
+    if (game->playerSequenceIndex >= game->sequenceLength)
+    {
+      SpeedUp(game);
+      game->score += game->playerSequenceIndex;
+
+      if (!game->marathon && game->sequenceLength >= SEQUENCE_CAPACITY)
+      {
+        if (game->score > game->highScore)
+        {
+          game->highScore = game->score;
+        }
+        EndRun(game, ANIMATION_TYPE_WIN);
+        return;
+      }
+
+      SoftReset(game);
+      game->sequenceLength++;
+
+      game->gameState = GAMESTATE_WAITING;
+      game->gameStateAfterWait = GAMESTATE_GAME;
+      game->gameStateWaitDuration = ROUND_WAIT_TIME;
+    }
+  } else
+  {
+    EndRun(game, ANIMATION_TYPE_GAMEOVER);
+  }
+}
+
+static void StepAnimation(CsimonGame* game)
+{
+  // Winning gets the same blinking, just a different title afterwards
+  if (!game->isShowingButtonAnimation)
+    return;
+
+  // Lit for two fifths of a second, off for one
+  if ((game->runTime * 5 / CSIMON_US_PER_SECOND) % 3 < 2)
+  {
+    if (game->gameoverBlinkAnimationState)
+    {
+      game->gameoverAnimationBlinkCount++;
+    }
+    LightButtons(game);
+    game->gameoverBlinkAnimationState = 0;
+  } else
+  {
+    game->gameoverBlinkAnimationState = 1;
+    ResetButtons(game);
+
+    if (game->gameoverAnimationBlinkCount >= GAMEOVER_BLINK_AMOUNT-1)
+    {
+      game->gameState = GAMESTATE_MENU_GAMEOVER;
+      game->gameStateWaitTime = 0;
+      game->gameoverBlinkAnimationState = 0;
+      game->gameoverAnimationBlinkCount = 0;
+      game->isShowingButtonAnimation = false;
+    }
+  }
+}
+
+void CsimonStep(CsimonGame* game, const CsimonInput* input, float dt)
+{
+  uint64_t dtUs = CsimonDtToUs(dt);
+  game->runTime += dtUs;
+
+  // Player can see their own presses whenever we aren't showing them something
+  if (
+      (!game->isShowingSequence && !game->isShowingButtonAnimation) ||
+      (game->gameState == GAMESTATE_WAITING && !game->isShowingSequence)
+     )
+  {
+    for (size_t i = 0; i < BUTTON_AMOUNT; i++)
+    {
+      game->buttonsLit[i] = input->buttonsDown[i];
+    }
+  }
+
+  if (input->toggleSequence)
+  {
+    game->isShowingSequence = !game->isShowingSequence;
+  }
+
+  switch (game->gameState)
+  {
+    case GAMESTATE_GAME:
+      if (game->isShowingSequence && !game->isShowingButtonAnimation)
+      {
+        StepSequence(game, dtUs);
+      } else if (!game->isShowingButtonAnimation)
+      {
+        game->inputWaitTime += dtUs;
+        StepPlayer(game, input->buttonPressed);
+      }
+
+      if (game->score > game->highScore)
+      {
+        game->highScore = game->score;
+      }
+      break;
+
+    case GAMESTATE_WAITING:
+      game->gameStateWaitTime += dtUs;
+      if (game->gameStateWaitTime > game->gameStateWaitDuration)
+      {
+        game->gameStateWaitDuration = 0;
+        game->gameStateWaitTime = 0;
+        game->gameState = game->gameStateAfterWait;
+        game->playerSequenceIndex = 0;
+        ResetButtons(game);
+      }
+      break;
+
+    case GAMESTATE_MENU:
+    case GAMESTATE_MENU_GAMEOVER:
+      game->menuTime += dtUs;
+      if (input->startDown)
+      {
+        game->gameState = GAMESTATE_GAME;
+      }
+      break;
+  }
+
+  StepAnimation(game);
+}
@@ -0,0 +1,146 @@
+#ifndef CSIMON_GAME_H
+#define CSIMON_GAME_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "rng.h"
+
+// Game logic only, no raylib in here so it can run headless (tools, bots, etc.)
+
+// Classic mode is won once the sequence gets this long, marathon mode keeps going
+#define SEQUENCE_CAPACITY 100
+#define INITIAL_SEQUENCE_DISPLAY_RATE 0.6
+#define SEQUENCE_DISPLAY_RATE_ACCELERATION 0.1
+#define SEQUENCE_DISPLAY_RATE_ACCELERATION_DECCELERATION 0.01
+#define MIN_SEQUENCE_DISPLAY_RATE 0.3
+
+#define OFF_TO_ON_SHOWING_SEQUENCE_RATIO 3
+
+#define BUTTON_AMOUNT 4
+
+#define GAMEOVER_BLINK_AMOUNT 3
+
+// Game clocks are all whole microseconds in 64 bits, a float of seconds stops
+// being able to tell frames apart after a few days of the cabinet sitting in the menu
+#define CSIMON_US_PER_SECOND 1000000ull
+#define ROUND_WAIT_TIME 200000ull // Between a round being cleared and the next sequence
+#define GAMEOVER_WAIT_TIME 2000000ull // Before the blinking, the end of a run just freezes
+
+enum { ANIMATION_TYPE_GAMEOVER, ANIMATION_TYPE_WIN };
+
+enum {
+ GAMESTATE_MENU,
+ GAMESTATE_MENU_GAMEOVER,
+ GAMESTATE_GAME,
+ GAMESTATE_WAITING
+};
+
+// How fast the sequence speeds up, defaults come from the macros above
+typedef struct CsimonDifficulty {
+  float initialDisplayRate;
+  float displayRateAcceleration;
+  float displayRateAccelerationDecceleration;
+  float minDisplayRate; // Rate stops speeding up once it gets here
+} CsimonDifficulty;
+
+// A button lighting up or going off while the sequence plays, time is in microseconds
+// from when playback started
+typedef struct CsimonSequenceEdge {
+  uint64_t time;
+  int button;
+  bool lit;
+} CsimonSequenceEdge;
+
+// Everything the logic needs to know about the player for one tick
+typedef struct CsimonInput {
+  bool buttonsDown[BUTTON_AMOUNT];
+  int buttonPressed; // -1 if nothing was pressed this tick
+  bool startDown;
+  bool toggleSequence; // Debug key
+} CsimonInput;
+
+typedef struct CsimonGame {
+  CsimonDifficulty difficulty;
+
+  uint64_t seed; // Whatever CsimonSeed was last given
+  CsimonRng rng;
+
+  int score;
+  int highScore;
+
+  // The sequence isn't stored, each button is worked out from this and its index
+  uint64_t sequenceSeed;
+  int sequenceLength;
+  int startLength; // Practice runs can start longer than 1
+  bool marathon;
+  int sequenceDisplayIndex;
+
+  float sequenceDisplayRateAcceleration;
+  float sequenceDisplayRate;
+  uint64_t sequenceTime; // Microseconds since the sequence started playing
+
+  uint64_t runTime; // Microseconds since the run (or the menu before it) started
+  uint64_t menuTime; // Microseconds in the menu, counted from the last round played
+
+  int playerSequenceIndex;
+
+  // Microseconds from the sequence finishing (or the last press) to each press
+  uint64_t inputWaitTime;
+  uint64_t lastReactionTime;
+  unsigned int pressCount; // Goes up with every press so a new lastReactionTime is easy to spot
+
+  bool buttonsLit[BUTTON_AMOUNT];
+
+  bool isShowingSequence;
+  bool isShowingButtonAnimation;
+
+  int animationType;
+
+  int gameoverAnimationBlinkCount;
+  int gameoverBlinkAnimationState;
+
+  int gameState;
+  int gameStateAfterWait;
+  uint64_t gameStateWaitDuration; // Microseconds
+  uint64_t gameStateWaitTime;
+
+  // How the last run ended, score is already reset by the time anyone looks
+  unsigned int runsFinished;
+  int lastScore;
+  int lastLength;
+} CsimonGame;
+
+CsimonDifficulty CsimonDefaultDifficulty(void);
+
+// Sets up a fresh game sitting in the menu with the default difficulty and seed 0, highScore is left alone
+void CsimonInit(CsimonGame* game);
+// Restarts the button generator, the same seed always gives the same sequences.
+// The first button is picked in CsimonReset, so call that afterwards for a fresh run
+void CsimonSeed(CsimonGame* game, uint64_t seed);
+// Ran whenever the player messes up or the game boots up
+void CsimonReset(CsimonGame* game);
+// Runs start with a sequence this long, sped up as if the earlier rounds were played.
+// Takes effect at the next CsimonReset
+void CsimonSetStartLength(CsimonGame* game, int length);
+// Button at any index of the current sequence, O(1)
+int CsimonSequenceButton(const CsimonGame* game, int index);
+// Sequence playback is a fixed timeline worked out when asked for, so it can't drift however
+// long it gets. A gap as long as a lit button, then each button off for a third of that and lit,
+// over as soon as the last one goes off. Edges 2i and 2i+1 are button i lighting up and going off
+int CsimonSequenceEdgeCount(const CsimonGame* game);
+// How long each button stays lit, microseconds
+uint64_t CsimonSequenceLitTime(const CsimonGame* game);
+CsimonSequenceEdge CsimonSequenceEdgeAt(const CsimonGame* game, int edge);
+uint64_t CsimonSequenceDuration(const CsimonGame* game);
+// First edge after the current playback time, CsimonSequenceEdgeCount if only the end is left
+int CsimonSequenceNextEdge(const CsimonGame* game);
+// Seconds to the whole microseconds the clocks count in, rounded the way CsimonStep does
+uint64_t CsimonDtToUs(float dt);
+// Advances the game by dt seconds
+void CsimonStep(CsimonGame* game, const CsimonInput* input, float dt);
+
+// Input with nothing held or pressed
+CsimonInput CsimonEmptyInput(void);
+
+#endif
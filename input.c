@@ -0,0 +1,477 @@
+#include "input.h"
+#include "inputthread.h"
+
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <raylib.h>
+
+#define BIT(n) (1u << (n))
+
+enum {
+  INPUT_PLATFORM_ANY,
+  INPUT_PLATFORM_DESKTOP,
+  INPUT_PLATFORM_WEB
+};
+
+#ifdef __EMSCRIPTEN__
+  #define INPUT_PLATFORM INPUT_PLATFORM_WEB
+#else
+  #define INPUT_PLATFORM INPUT_PLATFORM_DESKTOP
+#endif
+
+enum {
+  INPUT_SOURCE_BUTTON,
+  INPUT_SOURCE_AXIS,
+  INPUT_SOURCE_KEY
+};
+
+typedef struct InputBinding {
+  int platform;
+  int source;
+  int code;
+  int logical;
+} InputBinding;
+
+// Used when there's no input map file. Browsers report X and Y swapped
+static const InputBinding DEFAULT_BINDINGS[] = {
+  { INPUT_PLATFORM_DESKTOP, INPUT_SOURCE_BUTTON, GAMEPAD_BUTTON_RIGHT_FACE_LEFT,  INPUT_SIMON_0 }, // X
+  { INPUT_PLATFORM_DESKTOP, INPUT_SOURCE_BUTTON, GAMEPAD_BUTTON_RIGHT_TRIGGER_1,  INPUT_SIMON_0 }, // RShoulder
+  { INPUT_PLATFORM_DESKTOP, INPUT_SOURCE_BUTTON, GAMEPAD_BUTTON_RIGHT_FACE_UP,    INPUT_SIMON_1 }, // Y
+  { INPUT_PLATFORM_DESKTOP, INPUT_SOURCE_AXIS,   GAMEPAD_AXIS_LEFT_TRIGGER,       INPUT_SIMON_1 }, // LTrigger
+  { INPUT_PLATFORM_WEB,     INPUT_SOURCE_BUTTON, GAMEPAD_BUTTON_RIGHT_FACE_LEFT,  INPUT_SIMON_1 }, // X
+  { INPUT_PLATFORM_WEB,     INPUT_SOURCE_BUTTON, GAMEPAD_BUTTON_RIGHT_FACE_UP,    INPUT_SIMON_0 }, // Y
+  { INPUT_PLATFORM_ANY,     INPUT_SOURCE_BUTTON, GAMEPAD_BUTTON_RIGHT_FACE_RIGHT, INPUT_SIMON_2 }, // B
+  { INPUT_PLATFORM_ANY,     INPUT_SOURCE_BUTTON, GAMEPAD_BUTTON_RIGHT_FACE_DOWN,  INPUT_SIMON_3 }, // A
+  { INPUT_PLATFORM_ANY,     INPUT_SOURCE_BUTTON, GAMEPAD_BUTTON_MIDDLE_RIGHT,     INPUT_START },
+  { INPUT_PLATFORM_ANY,     INPUT_SOURCE_BUTTON, GAMEPAD_BUTTON_MIDDLE_LEFT,      INPUT_QUIT },
+  { INPUT_PLATFORM_ANY,     INPUT_SOURCE_KEY,    KEY_LEFT,                        INPUT_SIMON_0 },
+  { INPUT_PLATFORM_ANY,     INPUT_SOURCE_KEY,    KEY_UP,                          INPUT_SIMON_1 },
+  { INPUT_PLATFORM_ANY,     INPUT_SOURCE_KEY,    KEY_RIGHT,                       INPUT_SIMON_2 },
+  { INPUT_PLATFORM_ANY,     INPUT_SOURCE_KEY,    KEY_DOWN,                        INPUT_SIMON_3 },
+  { INPUT_PLATFORM_ANY,     INPUT_SOURCE_KEY,    KEY_ENTER,                       INPUT_START },
+  { INPUT_PLATFORM_ANY,     INPUT_SOURCE_KEY,    KEY_ZERO,                        INPUT_TOGGLE_SEQUENCE },
+  { INPUT_PLATFORM_ANY,     INPUT_SOURCE_KEY,    KEY_F9,                          INPUT_LATENCY_REPORT },
+};
+#define DEFAULT_BINDING_AMOUNT (sizeof(DEFAULT_BINDINGS) / sizeof(DEFAULT_BINDINGS[0]))
+
+typedef struct NamedCode {
+  const char* name;
+  int code;
+} NamedCode;
+
+static const NamedCode LOGICAL_NAMES[] = {
+  { "simon0", INPUT_SIMON_0 }, { "simon1", INPUT_SIMON_1 },
+  { "simon2", INPUT_SIMON_2 }, { "simon3", INPUT_SIMON_3 },
+  { "start", INPUT_START }, { "quit", INPUT_QUIT }, { "toggle", INPUT_TOGGLE_SEQUENCE },
+  { "report", INPUT_LATENCY_REPORT },
+  { NULL, 0 }
+};
+
+static const NamedCode BUTTON_NAMES[] = {
+  { "LEFT_FACE_UP", GAMEPAD_BUTTON_LEFT_FACE_UP }, { "LEFT_FACE_RIGHT", GAMEPAD_BUTTON_LEFT_FACE_RIGHT },
+  { "LEFT_FACE_DOWN", GAMEPAD_BUTTON_LEFT_FACE_DOWN }, { "LEFT_FACE_LEFT", GAMEPAD_BUTTON_LEFT_FACE_LEFT },
+  { "RIGHT_FACE_UP", GAMEPAD_BUTTON_RIGHT_FACE_UP }, { "RIGHT_FACE_RIGHT", GAMEPAD_BUTTON_RIGHT_FACE_RIGHT },
+  { "RIGHT_FACE_DOWN", GAMEPAD_BUTTON_RIGHT_FACE_DOWN }, { "RIGHT_FACE_LEFT", GAMEPAD_BUTTON_RIGHT_FACE_LEFT },
+  { "LEFT_TRIGGER_1", GAMEPAD_BUTTON_LEFT_TRIGGER_1 }, { "LEFT_TRIGGER_2", GAMEPAD_BUTTON_LEFT_TRIGGER_2 },
+  { "RIGHT_TRIGGER_1", GAMEPAD_BUTTON_RIGHT_TRIGGER_1 }, { "RIGHT_TRIGGER_2", GAMEPAD_BUTTON_RIGHT_TRIGGER_2 },
+  { "MIDDLE_LEFT", GAMEPAD_BUTTON_MIDDLE_LEFT }, { "MIDDLE", GAMEPAD_BUTTON_MIDDLE },
+  { "MIDDLE_RIGHT", GAMEPAD_BUTTON_MIDDLE_RIGHT }, { "LEFT_THUMB", GAMEPAD_BUTTON_LEFT_THUMB },
+  { "RIGHT_THUMB", GAMEPAD_BUTTON_RIGHT_THUMB },
+  { NULL, 0 }
+};
+
+static const NamedCode AXIS_NAMES[] = {
+  { "LEFT_X", GAMEPAD_AXIS_LEFT_X }, { "LEFT_Y", GAMEPAD_AXIS_LEFT_Y },
+  { "RIGHT_X", GAMEPAD_AXIS_RIGHT_X }, { "RIGHT_Y", GAMEPAD_AXIS_RIGHT_Y },
+  { "LEFT_TRIGGER", GAMEPAD_AXIS_LEFT_TRIGGER }, { "RIGHT_TRIGGER", GAMEPAD_AXIS_RIGHT_TRIGGER },
+  { NULL, 0 }
+};
+
+static const NamedCode KEY_NAMES[] = {
+  { "LEFT", KEY_LEFT }, { "UP", KEY_UP }, { "RIGHT", KEY_RIGHT }, { "DOWN", KEY_DOWN },
+  { "ENTER", KEY_ENTER }, { "SPACE", KEY_SPACE }, { "BACKSPACE", KEY_BACKSPACE }, { "TAB", KEY_TAB },
+  { "F9", KEY_F9 },
+  { NULL, 0 }
+};
+
+// A profile turns a controller's raw bits into logical bits, one mask per raw bit
+typedef struct InputProfile {
+  char name[INPUT_PROFILE_NAME_SIZE];
+  char match[INPUT_PROFILE_NAME_SIZE]; // Picked for pads whose name contains this
+  uint32_t table[32];
+} InputProfile;
+
+static InputProfile profiles[INPUT_MAX_PROFILES];
+static int profileCount = 0;
+static int forcedProfile = -1;
+static int slotProfile[INPUT_SLOT_AMOUNT];
+
+// The keyboard only reads the keys that are bound to something
+static int keyboardKeys[32];
+static uint32_t keyboardTable[32];
+static int keyboardKeyCount = 0;
+
+static uint32_t Translate(const uint32_t* table, uint32_t raw)
+{
+  uint32_t logical = 0;
+  for (int bit = 0; bit < 32; bit++)
+  {
+    logical |= table[bit] & (0u - ((raw >> bit) & 1u));
+  }
+  return logical;
+}
+
+static bool AddBinding(InputProfile* profile, int source, int code, int logical)
+{
+  if (source == INPUT_SOURCE_KEY)
+  {
+    int bit = 0;
+    while (bit < keyboardKeyCount && keyboardKeys[bit] != code)
+      bit++;
+    if (bit == 32)
+      return false;
+    if (bit == keyboardKeyCount)
+    {
+      keyboardKeys[keyboardKeyCount++] = code;
+    }
+    keyboardTable[bit] |= BIT(logical);
+    return true;
+  }
+
+  int bit = (source == INPUT_SOURCE_AXIS) ? INPUT_AXIS_BIT(code) : code;
+  if (profile == NULL || bit < 0 || bit >= INPUT_GAMEPAD_BUTTON_BITS + INPUT_GAMEPAD_AXIS_BITS ||
+      (source == INPUT_SOURCE_AXIS && code >= INPUT_GAMEPAD_AXIS_BITS))
+    return false;
+
+  profile->table[bit] |= BIT(logical);
+  return true;
+}
+
+static InputProfile* AddProfile(const char* name, const char* match)
+{
+  for (int i = 0; i < profileCount; i++)
+  {
+    if (strcmp(profiles[i].name, name) == 0)
+    {
+      // Redefining a profile starts it from scratch
+      memset(profiles[i].table, 0, sizeof(profiles[i].table));
+      snprintf(profiles[i].match, sizeof(profiles[i].match), "%s", match);
+      return &profiles[i];
+    }
+  }
+  if (profileCount >= INPUT_MAX_PROFILES)
+    return NULL;
+
+  InputProfile* profile = &profiles[profileCount++];
+  memset(profile, 0, sizeof(*profile));
+  snprintf(profile->name, sizeof(profile->name), "%s", name);
+  snprintf(profile->match, sizeof(profile->match), "%s", match);
+  return profile;
+}
+
+// Forced profile, else the first one whose match is in the name, else the default
+static int ProfileForName(const char* name)
+{
+  if (forcedProfile >= 0)
+    return forcedProfile;
+  if (name == NULL)
+    return 0;
+
+  for (int i = 0; i < profileCount; i++)
+  {
+    if (profiles[i].match[0] != '\0' && strstr(name, profiles[i].match) != NULL)
+      return i;
+  }
+  return 0;
+}
+
+static void PickProfile(int slot)
+{
+  slotProfile[slot] = ProfileForName(GetGamepadName(slot));
+}
+
+void InputInit(void)
+{
+  profileCount = 0;
+  keyboardKeyCount = 0;
+  memset(keyboardTable, 0, sizeof(keyboardTable));
+
+  InputProfile* profile = AddProfile("default", "");
+  for (size_t i = 0; i < DEFAULT_BINDING_AMOUNT; i++)
+  {
+    const InputBinding* binding = &DEFAULT_BINDINGS[i];
+    if (binding->platform == INPUT_PLATFORM_ANY || binding->platform == INPUT_PLATFORM)
+    {
+      AddBinding(profile, binding->source, binding->code, binding->logical);
+    }
+  }
+}
+
+static bool ParseCode(const NamedCode* names, const char* text, int* code)
+{
+  for (int i = 0; names[i].name != NULL; i++)
+  {
+    if (strcmp(names[i].name, text) == 0)
+    {
+      *code = names[i].code;
+      return true;
+    }
+  }
+
+  char* end;
+  long value = strtol(text, &end, 10);
+  if (end != text && *end == '\0')
+  {
+    *code = (int)value;
+    return true;
+  }
+  return false;
+}
+
+bool InputLoadMap(const char* path)
+{
+  FILE* file = fopen(path, "r");
+  if (file == NULL)
+    return false;
+
+  printf("Reading input map at %s\n", path);
+
+  InputProfile* profile = NULL;
+  bool clearedKeyboard = false;
+  char line[256];
+  int lineNumber = 0;
+
+  while (fgets(line, sizeof(line), file) != NULL)
+  {
+    lineNumber++;
+
+    char command[32], first[INPUT_PROFILE_NAME_SIZE], second[INPUT_PROFILE_NAME_SIZE];
+    second[0] = '\0';
+    int count = sscanf(line, "%31s %31s %31s", command, first, second);
+    if (count <= 0 || command[0] == '#')
+      continue;
+
+    bool ok = false;
+    if (strcmp(command, "profile") == 0 && count >= 2)
+    {
+      profile = AddProfile(first, second);
+      ok = profile != NULL;
+    } else if (count == 3)
+    {
+      int source = -1;
+      int code = 0;
+      int logical = 0;
+
+      if (strcmp(command, "button") == 0 && ParseCode(BUTTON_NAMES, first, &code))
+        source = INPUT_SOURCE_BUTTON;
+      else if (strcmp(command, "axis") == 0 && ParseCode(AXIS_NAMES, first, &code))
+        source = INPUT_SOURCE_AXIS;
+      else if (strcmp(command, "key") == 0)
+      {
+        if (strlen(first) == 1 && isalnum((unsigned char)first[0]))
+        {
+          code = toupper((unsigned char)first[0]);
+          source = INPUT_SOURCE_KEY;
+        } else if (ParseCode(KEY_NAMES, first, &code))
+        {
+          source = INPUT_SOURCE_KEY;
+        }
+      }
+
+      // Keys in a map file replace the built in ones rather than adding to them
+      if (source == INPUT_SOURCE_KEY && !clearedKeyboard)
+      {
+        keyboardKeyCount = 0;
+        memset(keyboardTable, 0, sizeof(keyboardTable));
+        clearedKeyboard = true;
+      }
+
+      // Pad bindings before any profile line go to the default profile
+      if (source != -1 && source != INPUT_SOURCE_KEY && profile == NULL)
+        profile = AddProfile("default", "");
+
+      if (source != -1 && ParseCode(LOGICAL_NAMES, second, &logical))
+        ok = AddBinding(profile, source, code, logical);
+    }
+
+    if (!ok)
+    {
+      fprintf(stderr, "%s:%d: could not understand \"%s\"\n", path, lineNumber, command);
+    }
+  }
+
+  fclose(file);
+  return true;
+}
+
+bool InputUseProfile(const char* name)
+{
+  for (int i = 0; i < profileCount; i++)
+  {
+    if (strcmp(profiles[i].name, name) == 0)
+    {
+      forcedProfile = i;
+      return true;
+    }
+  }
+  return false;
+}
+
+static uint32_t ReadGamepad(int gamepad)
+{
+  uint32_t down = 0;
+  for (int button = 1; button < INPUT_GAMEPAD_BUTTON_BITS; button++)
+  {
+    if (IsGamepadButtonDown(gamepad, button))
+      down |= BIT(button);
+  }
+  for (int axis = 0; axis < INPUT_GAMEPAD_AXIS_BITS; axis++)
+  {
+    if (GetGamepadAxisMovement(gamepad, axis) > GAMEPAD_AXISREGISTERTHRESHOLD)
+      down |= BIT(INPUT_AXIS_BIT(axis));
+  }
+  return down;
+}
+
+static uint32_t ReadKeyboard()
+{
+  uint32_t down = 0;
+  for (int i = 0; i < keyboardKeyCount; i++)
+  {
+    if (IsKeyDown(keyboardKeys[i]))
+      down |= BIT(i);
+  }
+  return down;
+}
+
+void InputSample(InputSnapshot* snapshot)
+{
+  uint32_t wasConnected = snapshot->connected;
+  snapshot->connected = BIT(INPUT_KEYBOARD_SLOT);
+  snapshot->anyDown = 0;
+  snapshot->anyPressed = 0;
+  snapshot->anyReleased = 0;
+
+  for (int slot = 0; slot < INPUT_SLOT_AMOUNT; slot++)
+  {
+    uint32_t down = 0;
+    uint32_t logical = 0;
+
+    if (slot == INPUT_KEYBOARD_SLOT)
+    {
+      down = ReadKeyboard();
+      logical = Translate(keyboardTable, down);
+    } else if (IsGamepadAvailable(slot))
+    {
+      snapshot->connected |= BIT(slot);
+      if (!(wasConnected & BIT(slot)))
+        PickProfile(slot);
+
+      down = ReadGamepad(slot);
+      logical = Translate(profiles[slotProfile[slot]].table, down);
+    }
+
+    // Every slot keeps its own previous state, so two pads can't confuse each other
+    snapshot->pressed[slot] = down & ~snapshot->down[slot];
+    snapshot->released[slot] = ~down & snapshot->down[slot];
+    snapshot->down[slot] = down;
+
+    snapshot->logicalPressed[slot] = logical & ~snapshot->logicalDown[slot];
+    snapshot->logicalReleased[slot] = ~logical & snapshot->logicalDown[slot];
+    snapshot->logicalDown[slot] = logical;
+
+    snapshot->anyDown |= snapshot->logicalDown[slot];
+    snapshot->anyPressed |= snapshot->logicalPressed[slot];
+    snapshot->anyReleased |= snapshot->logicalReleased[slot];
+  }
+
+  // Nothing else takes keys from raylib's queue, so it can just be emptied
+  snapshot->anyKeyPressed = false;
+  while (GetKeyPressed() != 0)
+  {
+    snapshot->anyKeyPressed = true;
+  }
+}
+
+bool InputDownAny(const InputSnapshot* snapshot, int logical)
+{
+  return (snapshot->anyDown & BIT(logical)) != 0;
+}
+
+bool InputPressedAny(const InputSnapshot* snapshot, int logical)
+{
+  return (snapshot->anyPressed & BIT(logical)) != 0;
+}
+
+bool InputAnyActivity(const InputSnapshot* snapshot)
+{
+  if (snapshot->anyKeyPressed)
+    return true;
+  for (int slot = 0; slot < INPUT_SLOT_AMOUNT; slot++)
+  {
+    if ((snapshot->down[slot] | snapshot->pressed[slot]) != 0)
+      return true;
+  }
+  return false;
+}
+
+CsimonInput InputToCsimon(const InputSnapshot* snapshot)
+{
+  CsimonInput input = CsimonEmptyInput();
+
+  for (int i = 0; i < BUTTON_AMOUNT; i++)
+  {
+    input.buttonsDown[i] = InputDownAny(snapshot, INPUT_SIMON_0 + i);
+    // Only one press counts per tick, highest button wins like it always has
+    if (InputPressedAny(snapshot, INPUT_SIMON_0 + i))
+      input.buttonPressed = i;
+  }
+  input.startDown = InputDownAny(snapshot, INPUT_START);
+  input.toggleSequence = InputPressedAny(snapshot, INPUT_TOGGLE_SEQUENCE);
+  return input;
+}
+
+uint32_t InputPadLogical(const char* padName, int button)
+{
+  if (button <= 0 || button >= INPUT_GAMEPAD_BUTTON_BITS)
+    return 0;
+  return profiles[ProfileForName(padName)].table[button];
+}
+
+uint32_t InputKeyLogical(int key)
+{
+  for (int i = 0; i < keyboardKeyCount; i++)
+  {
+    if (keyboardKeys[i] == key)
+      return keyboardTable[i];
+  }
+  return 0;
+}
+
+uint32_t InputPressedWithoutThread(const InputSnapshot* snapshot)
+{
+  if (!InputThreadRunning())
+    return snapshot->anyPressed;
+
+  uint32_t axes = ((1u << INPUT_GAMEPAD_AXIS_BITS) - 1) << INPUT_GAMEPAD_BUTTON_BITS;
+  uint32_t pressed = 0;
+  for (int slot = 0; slot < INPUT_SLOT_AMOUNT; slot++)
+  {
+    if (slot == INPUT_KEYBOARD_SLOT)
+    {
+      if (!InputThreadReadsKeyboard())
+        pressed |= snapshot->logicalPressed[slot];
+    } else if (snapshot->connected & BIT(slot))
+    {
+      // The thread only sees buttons, axes still come from here
+      if (InputThreadReadsPad(GetGamepadName(slot)))
+        pressed |= Translate(profiles[slotProfile[slot]].table, snapshot->pressed[slot] & axes);
+      else
+        pressed |= snapshot->logicalPressed[slot];
+    }
+  }
+  return pressed;
+}
@@ -0,0 +1,94 @@
+#ifndef CSIMON_INPUT_H
+#define CSIMON_INPUT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "game.h"
+
+// Every controller and the keyboard get read once a frame into bitmasks,
+// everything after that is just bit tests
+
+#define MAX_CONTROLLER_AMOUNT 8
+// Keyboard sits in the slot after the controllers
+#define INPUT_KEYBOARD_SLOT MAX_CONTROLLER_AMOUNT
+#define INPUT_SLOT_AMOUNT (MAX_CONTROLLER_AMOUNT + 1)
+
+#define GAMEPAD_AXISREGISTERTHRESHOLD 0.6
+
+#define INPUT_MAX_PROFILES 8
+#define INPUT_PROFILE_NAME_SIZE 32
+
+// Physical bits for a controller slot, buttons use their GAMEPAD_BUTTON_* number
+// and axes pushed past the threshold come after them
+#define INPUT_GAMEPAD_BUTTON_BITS 18
+#define INPUT_GAMEPAD_AXIS_BITS 6
+#define INPUT_AXIS_BIT(axis) (INPUT_GAMEPAD_BUTTON_BITS + (axis))
+
+// What the game actually cares about
+enum {
+  INPUT_SIMON_0,
+  INPUT_SIMON_1,
+  INPUT_SIMON_2,
+  INPUT_SIMON_3,
+  INPUT_START,
+  INPUT_QUIT,
+  INPUT_TOGGLE_SEQUENCE,
+  INPUT_LATENCY_REPORT,
+  INPUT_LOGICAL_AMOUNT
+};
+
+typedef struct InputSnapshot {
+  uint32_t connected; // One bit per slot
+
+  // Raw per slot
+  uint32_t down[INPUT_SLOT_AMOUNT];
+  uint32_t pressed[INPUT_SLOT_AMOUNT];
+  uint32_t released[INPUT_SLOT_AMOUNT];
+
+  // Logical per slot, one bit per INPUT_* above
+  uint32_t logicalDown[INPUT_SLOT_AMOUNT];
+  uint32_t logicalPressed[INPUT_SLOT_AMOUNT];
+  uint32_t logicalReleased[INPUT_SLOT_AMOUNT];
+
+  // Logical, any slot
+  uint32_t anyDown;
+  uint32_t anyPressed;
+  uint32_t anyReleased;
+
+  // Any key at all went down, including the ones the keyboard slot doesn't read
+  bool anyKeyPressed;
+} InputSnapshot;
+
+// Builds the lookup tables from the built in bindings, call before anything else here
+void InputInit(void);
+// Adds profiles from a text file on top of the built in one, false if it can't be opened.
+//   profile NAME [MATCH]     following pad bindings go to NAME, picked for pads whose name contains MATCH
+//   button CODE LOGICAL      CODE is a GAMEPAD_BUTTON_* name without the prefix, or its number
+//   axis AXIS LOGICAL        GAMEPAD_AXIS_* name without the prefix, counts once past the threshold
+//   key KEY LOGICAL          a letter / digit, LEFT, UP, ENTER, ... or a raylib KEY_* number
+// LOGICAL is one of simon0-3, start, quit, toggle, report. Lines starting with # are ignored
+bool InputLoadMap(const char* path);
+// Uses one profile for every pad no matter its name, for encoder boards that all look the same
+bool InputUseProfile(const char* name);
+
+// Reads everything, pressed / released come from comparing with what snapshot held before
+void InputSample(InputSnapshot* snapshot);
+
+bool InputDownAny(const InputSnapshot* snapshot, int logical);
+bool InputPressedAny(const InputSnapshot* snapshot, int logical);
+// Anything held or pressed in any slot, mapped to something or not
+bool InputAnyActivity(const InputSnapshot* snapshot);
+
+// What the game logic wants out of a snapshot
+CsimonInput InputToCsimon(const InputSnapshot* snapshot);
+
+// For the input thread, so evdev goes through the same profiles and keyboard bindings.
+// button is a GAMEPAD_BUTTON_* number, key a raylib KEY_*, both give INPUT_* bits, 0 if unbound
+uint32_t InputPadLogical(const char* padName, int button);
+uint32_t InputKeyLogical(int key);
+// INPUT_* bits pressed this frame, leaving out the devices the input thread is reading
+// (it delivers those itself, with better timestamps). Same as anyPressed without the thread
+uint32_t InputPressedWithoutThread(const InputSnapshot* snapshot);
+
+#endif
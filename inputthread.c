@@ -0,0 +1,373 @@
+#include "inputthread.h"
+
+#include <time.h>
+
+#include "input.h"
+
+#if defined(__linux__) && !defined(__EMSCRIPTEN__)
+
+#include <stdio.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/ioctl.h>
+#include <linux/input.h>
+
+#define MAX_DEVICES 16
+#define POLL_INTERVAL_MS 1
+#define RESCAN_INTERVAL_NS 2000000000ull
+
+// evdev numbers everything differently from raylib, these give the raylib GAMEPAD_BUTTON_* /
+// KEY_* number for a code so it can go through the profiles in input.c like raylib's input does.
+// Plain numbers since raylib.h can't be included next to linux/input.h
+typedef struct CodePair {
+  int evdev;
+  int raylib;
+} CodePair;
+
+// Pads using the kernel's standard gamepad layout. Anything else (encoder boards reporting
+// BTN_TRIGGER, BTN_THUMB, ...) only has a layout through raylib's mappings, so it's left to raylib
+static const CodePair PAD_BUTTONS[] = {
+  { BTN_DPAD_UP, 1 }, { BTN_DPAD_RIGHT, 2 }, { BTN_DPAD_DOWN, 3 }, { BTN_DPAD_LEFT, 4 },
+  { BTN_NORTH, 5 }, { BTN_EAST, 6 }, { BTN_SOUTH, 7 }, { BTN_WEST, 8 },
+  { BTN_TL, 9 }, { BTN_TL2, 10 }, { BTN_TR, 11 }, { BTN_TR2, 12 },
+  { BTN_SELECT, 13 }, { BTN_MODE, 14 }, { BTN_START, 15 }, { BTN_THUMBL, 16 }, { BTN_THUMBR, 17 },
+};
+#define PAD_BUTTON_AMOUNT (sizeof(PAD_BUTTONS) / sizeof(PAD_BUTTONS[0]))
+
+static const CodePair KEYS[] = {
+  { KEY_A, 'A' }, { KEY_B, 'B' }, { KEY_C, 'C' }, { KEY_D, 'D' }, { KEY_E, 'E' }, { KEY_F, 'F' },
+  { KEY_G, 'G' }, { KEY_H, 'H' }, { KEY_I, 'I' }, { KEY_J, 'J' }, { KEY_K, 'K' }, { KEY_L, 'L' },
+  { KEY_M, 'M' }, { KEY_N, 'N' }, { KEY_O, 'O' }, { KEY_P, 'P' }, { KEY_Q, 'Q' }, { KEY_R, 'R' },
+  { KEY_S, 'S' }, { KEY_T, 'T' }, { KEY_U, 'U' }, { KEY_V, 'V' }, { KEY_W, 'W' }, { KEY_X, 'X' },
+  { KEY_Y, 'Y' }, { KEY_Z, 'Z' },
+  { KEY_0, '0' }, { KEY_1, '1' }, { KEY_2, '2' }, { KEY_3, '3' }, { KEY_4, '4' },
+  { KEY_5, '5' }, { KEY_6, '6' }, { KEY_7, '7' }, { KEY_8, '8' }, { KEY_9, '9' },
+  { KEY_SPACE, 32 }, { KEY_ENTER, 257 }, { KEY_TAB, 258 }, { KEY_BACKSPACE, 259 },
+  { KEY_RIGHT, 262 }, { KEY_LEFT, 263 }, { KEY_DOWN, 264 }, { KEY_UP, 265 },
+  { KEY_F1, 290 }, { KEY_F2, 291 }, { KEY_F3, 292 }, { KEY_F4, 293 }, { KEY_F5, 294 }, { KEY_F6, 295 },
+  { KEY_F7, 296 }, { KEY_F8, 297 }, { KEY_F9, 298 }, { KEY_F10, 299 }, { KEY_F11, 300 }, { KEY_F12, 301 },
+};
+#define KEY_AMOUNT (sizeof(KEYS) / sizeof(KEYS[0]))
+
+typedef struct Device {
+  int fd;
+  char node[32];  // eventN
+  char name[128]; // What the device calls itself, the same name raylib gives the pad
+  bool isPad;
+} Device;
+
+// Only the input thread changes the list once it's running, the lock is for the main thread
+// asking which devices it has
+static Device devices[MAX_DEVICES];
+static int deviceCount = 0;
+static pthread_mutex_t devicesLock = PTHREAD_MUTEX_INITIALIZER;
+
+static InputEvent queue[INPUT_THREAD_QUEUE_SIZE];
+static atomic_uint_fast32_t queueHead; // Written by the input thread
+static atomic_uint_fast32_t queueTail; // Written by the main thread
+static atomic_uint_fast64_t dropped;
+
+static pthread_t thread;
+static atomic_bool running;
+
+static int RaylibCode(const CodePair* pairs, size_t amount, int code)
+{
+  for (size_t i = 0; i < amount; i++)
+  {
+    if (pairs[i].evdev == code)
+      return pairs[i].raylib;
+  }
+  return -1;
+}
+
+// INPUT_* bits for a code on this device, 0 if it isn't bound to anything
+static uint32_t LogicalForCode(const Device* device, int code)
+{
+  if (device->isPad)
+    return InputPadLogical(device->name, RaylibCode(PAD_BUTTONS, PAD_BUTTON_AMOUNT, code));
+
+  int key = RaylibCode(KEYS, KEY_AMOUNT, code);
+  return (key < 0) ? 0 : InputKeyLogical(key);
+}
+
+static bool Push(InputEvent event)
+{
+  uint_fast32_t head = atomic_load_explicit(&queueHead, memory_order_relaxed);
+  uint_fast32_t tail = atomic_load_explicit(&queueTail, memory_order_acquire);
+  if (head - tail >= INPUT_THREAD_QUEUE_SIZE)
+  {
+    atomic_fetch_add_explicit(&dropped, 1, memory_order_relaxed);
+    return false;
+  }
+
+  queue[head & (INPUT_THREAD_QUEUE_SIZE - 1)] = event;
+  atomic_store_explicit(&queueHead, head + 1, memory_order_release);
+  return true;
+}
+
+bool InputThreadPop(InputEvent* event)
+{
+  uint_fast32_t tail = atomic_load_explicit(&queueTail, memory_order_relaxed);
+  uint_fast32_t head = atomic_load_explicit(&queueHead, memory_order_acquire);
+  if (tail == head)
+    return false;
+
+  *event = queue[tail & (INPUT_THREAD_QUEUE_SIZE - 1)];
+  atomic_store_explicit(&queueTail, tail + 1, memory_order_release);
+  return true;
+}
+
+static bool IsOpen(const char* node)
+{
+  for (int i = 0; i < deviceCount; i++)
+  {
+    if (strcmp(devices[i].node, node) == 0)
+      return true;
+  }
+  return false;
+}
+
+// Pads are told apart by having the standard face buttons, then either kind is only worth
+// reading if one of its codes is bound in the profile or keyboard bindings it'll be read with
+static bool HasBoundKeys(int fd, Device* device)
+{
+  unsigned char keys[KEY_MAX / 8 + 1];
+  memset(keys, 0, sizeof(keys));
+  if (ioctl(fd, EVIOCGBIT(EV_KEY, sizeof(keys)), keys) < 0)
+    return false;
+
+  device->isPad = (keys[BTN_SOUTH / 8] & (1 << (BTN_SOUTH % 8))) != 0;
+  const CodePair* pairs = device->isPad ? PAD_BUTTONS : KEYS;
+  size_t amount = device->isPad ? PAD_BUTTON_AMOUNT : KEY_AMOUNT;
+  for (size_t i = 0; i < amount; i++)
+  {
+    int code = pairs[i].evdev;
+    if ((keys[code / 8] & (1 << (code % 8))) && LogicalForCode(device, code) != 0)
+      return true;
+  }
+  return false;
+}
+
+static void ScanDevices()
+{
+  DIR* dir = opendir("/dev/input");
+  if (dir == NULL)
+    return;
+
+  struct dirent* entry;
+  while ((entry = readdir(dir)) != NULL && deviceCount < MAX_DEVICES)
+  {
+    if (strncmp(entry->d_name, "event", 5) != 0 || strlen(entry->d_name) >= sizeof(devices[0].node) ||
+        IsOpen(entry->d_name))
+      continue;
+
+    char path[64];
+    snprintf(path, sizeof(path), "/dev/input/%.31s", entry->d_name);
+    int fd = open(path, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0)
+      continue;
+
+    Device device;
+    memset(&device, 0, sizeof(device));
+    device.fd = fd;
+    strcpy(device.node, entry->d_name);
+    if (ioctl(fd, EVIOCGNAME(sizeof(device.name) - 1), device.name) < 0)
+      strcpy(device.name, "Unknown");
+
+    // Have the kernel stamp events with the same clock as InputThreadNow
+    int clock = CLOCK_MONOTONIC;
+    if (!HasBoundKeys(fd, &device) || ioctl(fd, EVIOCSCLOCKID, &clock) < 0)
+    {
+      close(fd);
+      continue;
+    }
+
+    pthread_mutex_lock(&devicesLock);
+    devices[deviceCount++] = device;
+    pthread_mutex_unlock(&devicesLock);
+  }
+  closedir(dir);
+}
+
+static void CloseDevice(int index)
+{
+  close(devices[index].fd);
+  pthread_mutex_lock(&devicesLock);
+  devices[index] = devices[--deviceCount];
+  pthread_mutex_unlock(&devicesLock);
+}
+
+static void ReadDevice(int index)
+{
+  struct input_event events[64];
+  while (true)
+  {
+    ssize_t size = read(devices[index].fd, events, sizeof(events));
+    if (size < 0)
+    {
+      // Unplugged
+      if (errno != EAGAIN && errno != EINTR)
+        CloseDevice(index);
+      return;
+    }
+
+    for (size_t i = 0; i < (size_t)size / sizeof(struct input_event); i++)
+    {
+      // 2 is key repeat, only real presses and releases count
+      if (events[i].type != EV_KEY || events[i].value > 1)
+        continue;
+
+      uint32_t logical = LogicalForCode(&devices[index], events[i].code);
+
+      InputEvent event;
+      event.time = (uint64_t)events[i].input_event_sec * 1000000000ull +
+        (uint64_t)events[i].input_event_usec * 1000ull;
+      event.pressed = events[i].value == 1;
+      // One event per logical it's bound to, a key can be on more than one
+      for (int bit = 0; bit < INPUT_LOGICAL_AMOUNT; bit++)
+      {
+        if (logical & (1u << bit))
+        {
+          event.logical = bit;
+          Push(event);
+        }
+      }
+    }
+  }
+}
+
+static void* ThreadMain(void* arg)
+{
+  (void)arg;
+  uint64_t lastScan = InputThreadNow();
+
+  while (atomic_load(&running))
+  {
+    struct pollfd fds[MAX_DEVICES];
+    for (int i = 0; i < deviceCount; i++)
+    {
+      fds[i].fd = devices[i].fd;
+      fds[i].events = POLLIN;
+      fds[i].revents = 0;
+    }
+
+    int ready = poll(fds, deviceCount, POLL_INTERVAL_MS);
+    if (ready > 0)
+    {
+      // Backwards since CloseDevice moves the last device into the gap
+      for (int i = deviceCount - 1; i >= 0; i--)
+      {
+        if (fds[i].revents & (POLLIN | POLLERR | POLLHUP))
+          ReadDevice(i);
+      }
+    }
+
+    uint64_t now = InputThreadNow();
+    if (now - lastScan > RESCAN_INTERVAL_NS)
+    {
+      ScanDevices();
+      lastScan = now;
+    }
+  }
+  return NULL;
+}
+
+bool InputThreadStart(void)
+{
+  ScanDevices();
+  if (deviceCount == 0)
+  {
+    printf("Input thread found no readable devices in /dev/input, using raylib input\n");
+    return false;
+  }
+
+  atomic_store(&queueHead, 0);
+  atomic_store(&queueTail, 0);
+  atomic_store(&dropped, 0);
+  atomic_store(&running, true);
+  if (pthread_create(&thread, NULL, ThreadMain, NULL) != 0)
+  {
+    perror("Could not start input thread");
+    atomic_store(&running, false);
+    return false;
+  }
+
+  printf("Input thread reading %d devices\n", deviceCount);
+  return true;
+}
+
+void InputThreadStop(void)
+{
+  if (!atomic_load(&running))
+    return;
+
+  atomic_store(&running, false);
+  pthread_join(thread, NULL);
+  while (deviceCount > 0)
+  {
+    CloseDevice(deviceCount - 1);
+  }
+}
+
+bool InputThreadRunning(void)
+{
+  return atomic_load(&running);
+}
+
+uint64_t InputThreadDropped(void)
+{
+  return atomic_load(&dropped);
+}
+
+bool InputThreadReadsKeyboard(void)
+{
+  bool found = false;
+  pthread_mutex_lock(&devicesLock);
+  for (int i = 0; i < deviceCount && !found; i++)
+  {
+    found = !devices[i].isPad;
+  }
+  pthread_mutex_unlock(&devicesLock);
+  return found && InputThreadRunning();
+}
+
+bool InputThreadReadsPad(const char* name)
+{
+  if (name == NULL)
+    return false;
+
+  bool found = false;
+  pthread_mutex_lock(&devicesLock);
+  for (int i = 0; i < deviceCount && !found; i++)
+  {
+    found = devices[i].isPad && strncmp(devices[i].name, name, sizeof(devices[i].name) - 1) == 0;
+  }
+  pthread_mutex_unlock(&devicesLock);
+  return found && InputThreadRunning();
+}
+
+#else
+
+// No evdev here, the game just uses raylib input
+bool InputThreadStart(void) { return false; }
+void InputThreadStop(void) {}
+bool InputThreadRunning(void) { return false; }
+bool InputThreadPop(InputEvent* event) { (void)event; return false; }
+uint64_t InputThreadDropped(void) { return 0; }
+bool InputThreadReadsKeyboard(void) { return false; }
+bool InputThreadReadsPad(const char* name) { (void)name; return false; }
+
+#endif
+
+uint64_t InputThreadNow(void)
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+}
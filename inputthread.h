@@ -0,0 +1,36 @@
+#ifndef CSIMON_INPUTTHREAD_H
+#define CSIMON_INPUTTHREAD_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Optional thread that reads button presses straight from evdev (Linux only)
+// with kernel timestamps, instead of waiting for raylib to poll once a frame.
+// Presses go through a lock free single producer / single consumer queue.
+// Codes are translated with the same profiles and keyboard bindings as raylib input, and
+// only devices the thread can translate get opened, raylib keeps reading the rest.
+
+#define INPUT_THREAD_QUEUE_SIZE 256 // Must be a power of two
+
+typedef struct InputEvent {
+  uint64_t time; // InputThreadNow() clock, nanoseconds
+  int logical;   // INPUT_* from input.h
+  bool pressed;
+} InputEvent;
+
+// False if there's no evdev or no readable devices, the game then carries on with raylib input
+bool InputThreadStart(void);
+void InputThreadStop(void);
+bool InputThreadRunning(void);
+// Main thread only
+bool InputThreadPop(InputEvent* event);
+// Monotonic nanoseconds, same clock the events are stamped with
+uint64_t InputThreadNow(void);
+// Events thrown away because the game wasn't draining the queue
+uint64_t InputThreadDropped(void);
+// Whether the thread has a keyboard / a pad with this (raylib's GetGamepadName) name open,
+// their presses shouldn't be taken from raylib as well
+bool InputThreadReadsKeyboard(void);
+bool InputThreadReadsPad(const char* name);
+
+#endif
@@ -0,0 +1,81 @@
+#include "latency.h"
+
+#include <stdio.h>
+
+static int BucketFor(uint64_t ns)
+{
+  if (ns < LATENCY_SUB_BUCKETS)
+    return (int)ns;
+
+  int exponent = 63 - __builtin_clzll(ns);
+  int sub = (int)((ns >> (exponent - 3)) & (LATENCY_SUB_BUCKETS - 1));
+  int bucket = (exponent - 2) * LATENCY_SUB_BUCKETS + sub;
+  return bucket < LATENCY_BUCKET_AMOUNT ? bucket : LATENCY_BUCKET_AMOUNT - 1;
+}
+
+static uint64_t BucketUpperEdge(int bucket)
+{
+  if (bucket < LATENCY_SUB_BUCKETS)
+    return (uint64_t)bucket;
+
+  int exponent = bucket / LATENCY_SUB_BUCKETS + 2;
+  uint64_t sub = (uint64_t)(bucket % LATENCY_SUB_BUCKETS);
+  uint64_t lower = (LATENCY_SUB_BUCKETS + sub) << (exponent - 3);
+  return lower + (1ull << (exponent - 3)) - 1;
+}
+
+void LatencyAdd(LatencyHistogram* histogram, uint64_t ns)
+{
+  histogram->counts[BucketFor(ns)]++;
+  histogram->total++;
+  histogram->sum += (double)ns;
+  if (ns > histogram->max) histogram->max = ns;
+}
+
+uint64_t LatencyPercentile(const LatencyHistogram* histogram, double p)
+{
+  if (histogram->total == 0)
+    return 0;
+
+  uint64_t target = (uint64_t)(p * (double)(histogram->total - 1));
+  uint64_t seen = 0;
+  for (int i = 0; i < LATENCY_BUCKET_AMOUNT; i++)
+  {
+    seen += histogram->counts[i];
+    if (seen > target)
+    {
+      uint64_t edge = BucketUpperEdge(i);
+      return edge < histogram->max ? edge : histogram->max;
+    }
+  }
+  return histogram->max;
+}
+
+static void WriteLine(FILE* file, const char* name, const LatencyHistogram* histogram)
+{
+  double mean = histogram->total ? histogram->sum / (double)histogram->total : 0.0;
+  fprintf(file, "%-16s samples %8llu  mean %7.2f  p50 %7.2f  p95 %7.2f  p99 %7.2f  max %7.2f ms\n",
+      name, (unsigned long long)histogram->total,
+      mean / 1e6,
+      LatencyPercentile(histogram, 0.50) / 1e6,
+      LatencyPercentile(histogram, 0.95) / 1e6,
+      LatencyPercentile(histogram, 0.99) / 1e6,
+      histogram->max / 1e6);
+}
+
+bool LatencyWriteReport(const char* path, const LatencyHistogram* pressLatency, const LatencyHistogram* frameTimes)
+{
+  printf("Writing latency report at %s\n", path);
+  FILE* file = fopen(path, "w");
+
+  if (file == NULL)
+  {
+    perror("Error writing latency report");
+    return false;
+  }
+
+  WriteLine(file, "input to photon", pressLatency);
+  WriteLine(file, "frame time", frameTimes);
+
+  return fclose(file) == 0;
+}
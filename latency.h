@@ -0,0 +1,27 @@
+#ifndef CSIMON_LATENCY_H
+#define CSIMON_LATENCY_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Fixed size log scale histogram of nanosecond timings, 8 buckets per power of two
+// so percentiles are good to about 12%. Adding a sample never allocates.
+
+#define LATENCY_SUB_BUCKETS 8
+#define LATENCY_BUCKET_AMOUNT (62 * LATENCY_SUB_BUCKETS)
+
+typedef struct LatencyHistogram {
+  uint32_t counts[LATENCY_BUCKET_AMOUNT];
+  uint64_t total;
+  uint64_t max;
+  double sum;
+} LatencyHistogram;
+
+void LatencyAdd(LatencyHistogram* histogram, uint64_t ns);
+// Upper edge of the bucket holding the p-th sample, p in [0, 1]
+uint64_t LatencyPercentile(const LatencyHistogram* histogram, double p);
+
+// Input to photon and frame time percentiles as text
+bool LatencyWriteReport(const char* path, const LatencyHistogram* pressLatency, const LatencyHistogram* frameTimes);
+
+#endif
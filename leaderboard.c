@@ -0,0 +1,183 @@
+#include "leaderboard.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#if defined(_WIN32)
+  #include <windows.h>
+  #define LEADERBOARD_MAPPED
+#elif !defined(__EMSCRIPTEN__)
+  #include <sys/mman.h>
+  #include <fcntl.h>
+  #include <unistd.h>
+  #define LEADERBOARD_MAPPED
+#endif
+
+#define LEADERBOARD_MAGIC "CSLB"
+
+static Leaderboard memoryBoard;
+static Leaderboard* board = &memoryBoard;
+
+#if defined(_WIN32)
+  static HANDLE file = INVALID_HANDLE_VALUE;
+  static HANDLE mapping = NULL;
+#elif defined(LEADERBOARD_MAPPED)
+  static int file = -1;
+#endif
+
+static bool IsValid(const Leaderboard* leaderboard)
+{
+  return memcmp(leaderboard->magic, LEADERBOARD_MAGIC, 4) == 0 &&
+    leaderboard->version == LEADERBOARD_VERSION &&
+    leaderboard->size == LEADERBOARD_SIZE &&
+    leaderboard->count <= LEADERBOARD_SIZE;
+}
+
+static void StartOver(Leaderboard* leaderboard)
+{
+  memset(leaderboard, 0, sizeof(*leaderboard));
+  memcpy(leaderboard->magic, LEADERBOARD_MAGIC, 4);
+  leaderboard->version = LEADERBOARD_VERSION;
+  leaderboard->size = LEADERBOARD_SIZE;
+}
+
+#ifdef LEADERBOARD_MAPPED
+
+// New files come out zeroed, which IsValid turns down, so they get started over like corrupt ones
+static Leaderboard* MapFile(const char* path)
+{
+#ifdef _WIN32
+  file = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (file == INVALID_HANDLE_VALUE)
+    return NULL;
+
+  // Grows the file to the right size if it's shorter
+  mapping = CreateFileMappingA(file, NULL, PAGE_READWRITE, 0, sizeof(Leaderboard), NULL);
+  void* view = (mapping != NULL) ? MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, sizeof(Leaderboard)) : NULL;
+  if (view == NULL)
+  {
+    if (mapping != NULL) CloseHandle(mapping);
+    CloseHandle(file);
+    mapping = NULL;
+    file = INVALID_HANDLE_VALUE;
+    return NULL;
+  }
+  return view;
+#else
+  file = open(path, O_RDWR | O_CREAT, 0644);
+  if (file < 0)
+    return NULL;
+
+  void* view = MAP_FAILED;
+  if (ftruncate(file, sizeof(Leaderboard)) == 0)
+    view = mmap(NULL, sizeof(Leaderboard), PROT_READ | PROT_WRITE, MAP_SHARED, file, 0);
+  if (view == MAP_FAILED)
+  {
+    close(file);
+    file = -1;
+    return NULL;
+  }
+  return view;
+#endif
+}
+
+// Gets the page written back without waiting for it
+static void Flush(void)
+{
+  if (board == &memoryBoard)
+    return;
+#ifdef _WIN32
+  FlushViewOfFile(board, sizeof(Leaderboard));
+#else
+  msync(board, sizeof(Leaderboard), MS_ASYNC);
+#endif
+}
+
+#endif
+
+const Leaderboard* LeaderboardOpen(const char* path)
+{
+  LeaderboardClose();
+
+#ifdef LEADERBOARD_MAPPED
+  Leaderboard* mapped = MapFile(path);
+  if (mapped != NULL)
+  {
+    board = mapped;
+  } else
+  {
+    perror("Error mapping leaderboard, it won't be kept");
+  }
+#else
+  (void)path;
+#endif
+
+  if (!IsValid(board))
+  {
+    if (board->version != 0)
+      printf("Leaderboard at %s is unreadable, starting it over\n", path);
+    StartOver(board);
+  }
+  return board;
+}
+
+void LeaderboardClose(void)
+{
+#ifdef LEADERBOARD_MAPPED
+  if (board != &memoryBoard)
+  {
+    Flush();
+#ifdef _WIN32
+    UnmapViewOfFile(board);
+    CloseHandle(mapping);
+    CloseHandle(file);
+    mapping = NULL;
+    file = INVALID_HANDLE_VALUE;
+#else
+    munmap(board, sizeof(Leaderboard));
+    close(file);
+    file = -1;
+#endif
+  }
+#endif
+  board = &memoryBoard;
+}
+
+bool LeaderboardQualifies(int score)
+{
+  return board->count < LEADERBOARD_SIZE || score > board->entries[LEADERBOARD_SIZE - 1].score;
+}
+
+int LeaderboardInsert(const LeaderboardEntry* entry)
+{
+  // First entry it beats, after any it only ties with
+  uint32_t low = 0;
+  uint32_t high = board->count;
+  while (low < high)
+  {
+    uint32_t middle = (low + high) / 2;
+    if (board->entries[middle].score >= entry->score)
+      low = middle + 1;
+    else
+      high = middle;
+  }
+  if (low >= LEADERBOARD_SIZE)
+    return -1;
+
+  // Everything below moves down one, whatever was last falls off a full board
+  uint32_t moved = board->count - low;
+  if (board->count == LEADERBOARD_SIZE)
+    moved--;
+  memmove(&board->entries[low + 1], &board->entries[low], moved * sizeof(LeaderboardEntry));
+
+  board->entries[low] = *entry;
+  board->entries[low].initials[LEADERBOARD_INITIALS] = '\0';
+  if (board->count < LEADERBOARD_SIZE)
+    board->count++;
+  board->changes++;
+
+#ifdef LEADERBOARD_MAPPED
+  Flush();
+#endif
+  return (int)low;
+}
@@ -0,0 +1,43 @@
+#ifndef CSIMON_LEADERBOARD_H
+#define CSIMON_LEADERBOARD_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Top LEADERBOARD_SIZE scores, kept in a file that's memory mapped and changed in place.
+// The file is the struct below byte for byte (native byte order, it never leaves the
+// cabinet), so opening it is just mapping it, and the menu draws straight from the map.
+// Entries are sorted best first, equal scores keep the order they came in. If the
+// mapping can't be made (web build, read-only disk) the board lives in memory instead.
+
+#define LEADERBOARD_VERSION 1
+#define LEADERBOARD_SIZE 10
+#define LEADERBOARD_INITIALS 3
+
+typedef struct LeaderboardEntry {
+  char initials[LEADERBOARD_INITIALS + 1];
+  int32_t score;
+  int64_t date; // Unix seconds
+  uint64_t seed; // The run's sequenceSeed
+} LeaderboardEntry;
+
+typedef struct Leaderboard {
+  char magic[4]; // "CSLB"
+  uint32_t version;
+  uint32_t size; // LEADERBOARD_SIZE it was made with, a different one starts over
+  uint32_t count;
+  uint32_t changes; // Goes up on every insert, so drawing code can tell when to lay out again
+  uint32_t reserved;
+  LeaderboardEntry entries[LEADERBOARD_SIZE];
+} Leaderboard;
+
+// Never NULL, a file that isn't a leaderboard gets started over
+const Leaderboard* LeaderboardOpen(const char* path);
+void LeaderboardClose(void);
+
+// Whether a score would make it on the board
+bool LeaderboardQualifies(int score);
+// Where it landed (0 is the top), -1 if it didn't make it
+int LeaderboardInsert(const LeaderboardEntry* entry);
+
+#endif
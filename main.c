@@ -1,39 +1,137 @@
 #include <stdio.h>
 #include <stdbool.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 #include <raylib.h>
-
-#include "res/roboto.h"
+#include <rlgl.h>
+
+#include "game.h"
+#include "input.h"
+#include "inputthread.h"
+#include "latency.h"
+#include "bot.h"
+#include "tween.h"
+#include "replay.h"
+#include "save.h"
+#include "stats.h"
+#include "leaderboard.h"
+#include "font.h"
+#include "circle.h"
 
 #define APP_TITLE "Simon"
-#define SEQUENCE_CAPACITY 100
-#define INITIAL_SEQUENCE_DISPLAY_RATE 0.6
-#define SEQUENCE_DISPLAY_RATE_ACCELERATION 0.1
-#define SEQUENCE_DISPLAY_RATE_ACCELERATION_DECCELERATION 0.01
-
-#define OFF_TO_ON_SHOWING_SEQUENCE_RATIO 3
-
-#define MAX_CONTROLLER_AMOUNT 8
 
-#define BUTTON_AMOUNT 4
 #define BUTTON_SIZE 50
 #define BUTTON_LIT_SIZE 55
-#define BUTTON_COLOR_INTERPOLATION 0.4
-#define BUTTON_SIZE_INTERPOLATION 0.4
+// Colors fade like the old 0.4 a frame lerp did at 60 fps
+#define BUTTON_COLOR_RATE TweenRateFromLerp(0.4f, 60.f)
+#define BUTTON_SIZE_SPRING_RATE 40.f
 
 #define SAVEFILE_FILEPATH ".csimon"
-
-#define MENU_TITLE "PRESS START"
-#define GAMEOVER_TITLE "GAME OVER!"
-#define GAMEOVER_BLINK_AMOUNT 3
-
-#define AUTHOR "Made by flebedev77"
-
-#define GAMEPAD_AXISREGISTERTHRESHOLD 0.6
-
-static int score = 0;
-static int highScore = 0;
+#define INPUTMAP_FILEPATH ".csimon_input"
+#define LEADERBOARD_FILEPATH ".csimon_leaderboard"
+#define STATS_FILEPATH ".csimon_stats_" // Followed by the player name
+#define LATENCY_REPORT_FILEPATH "csimon_latency.txt"
+#define LATENCY_PRESS_TIMEOUT 250000000ull // ns
+
+// Power save mode polls input this often while it has nothing to draw
+#define POWER_SAVE_POLL_INTERVAL 0.008
+// Close enough to the target to stop redrawing for, colors are 0-255 and sizes in pixels
+#define POWER_SAVE_SETTLE_EPSILON 0.05f
+
+#define MENU_RESULT_TIME 3000000ull // us the game over / win title stays up for
+#define ATTRACT_TIMEOUT 60.f // Seconds in the menu before the demo starts
+// Ticks of a demo replay's menu time that can be skipped in one frame, keeps a replay of someone
+// standing about from costing anything
+#define ATTRACT_MAX_SKIP_TICKS 10000
+// Fixed tick mode drops time instead of trying to catch up after a stall longer than this
+#define FIXED_TICK_MAX_CATCHUP 250000000ull // ns
+
+// Everything is drawn from the one baked font, scaled
+#define FONT_SIZE_SM 20
+#define FONT_SIZE 30
+#define FONT_SIZE_LG FONT_ATLAS_SIZE
+
+static CsimonGame game;
+static CsimonInput input;
+static InputSnapshot inputSnapshot;
+
+static ReplayWriter replayWriter;
+static ReplayReader replayReader;
+static const char* recordPath = NULL;
+static const char* replayPath = NULL;
+static long replayRound = -1;
+static const char* inputMapPath = INPUTMAP_FILEPATH;
+static const char* inputProfile = NULL;
+static bool useInputThread = false;
+static uint64_t lastStepTime = 0;
+
+// 0 steps the game once a frame, otherwise at a fixed rate on its own clock
+static int tickRate = 0;
+static int targetFps = 60;
+static bool useVsync = false;
+static uint64_t tickTime = 0;
+static uint64_t logicTime = 0;
+static int carriedPress = -1; // Presses from frames that didn't get a tick wait for the next one
+static bool carriedToggle = false;
+static InputEvent heldEvent;
+static bool hasHeldEvent = false;
+static double replayLag = 0.0;
+
+// Every round's sequence timeline gets appended here, for syncing audio to
+static const char* timelinePath = NULL;
+static FILE* timelineFile = NULL;
+static unsigned int timelineRun = 0;
+static int timelineLength = 0;
+
+// Attract mode, a demo game played on the buttons while nobody's at the cabinet. It has its own
+// game, the real one keeps sitting in the menu taking input underneath
+static const char* attractPath = NULL;
+static float attractTimeout = ATTRACT_TIMEOUT;
+static bool attractActive = false;
+static bool attractFromReplay = false;
+static double attractIdle = 0.0;
+static double attractLag = 0.0;
+static CsimonGame attractGame;
+static ReplayReader attractReader;
+static Bot attractBot;
+
+// Clocks from the tick before, so drawing can land between ticks
+static uint64_t previousRunTime;
+static uint64_t previousMenuTime;
+static float renderAlpha = 1.f;
+
+// Press to first drawn frame, and frame to frame, all on the InputThreadNow() clock
+static const char* latencyReportPath = NULL;
+static LatencyHistogram pressLatency;
+static LatencyHistogram frameTimes;
+static uint64_t pendingPressTime[BUTTON_AMOUNT]; // 0 when no press is waiting to be shown
+static uint64_t lastFrameEnd = 0; // 0 after an idle stretch, so it doesn't count as a frame
+static uint64_t lastPollTime = 0;
+
+// The run being played, it goes in the player's stats log the tick it ends
+static const char* playerName = "default";
+static const char* statsReportPath = NULL;
+static StatsStore stats;
+static StatsRun statsRun;
+static unsigned int statsPressCount = 0;
+static unsigned int statsRunsFinished = 0;
+
+// Straight from the mapped file, the rows only get laid out again when it changes
+static const Leaderboard* leaderboard;
+static const char* initials = NULL;
+static char runInitials[LEADERBOARD_INITIALS + 1];
+static TextLayout leaderboardLayouts[LEADERBOARD_SIZE];
+static uint32_t shownLeaderboardChanges = 0;
+static float leaderboardWidth = 0.f;
+
+// raylib can only wait for events with no timeout, GLFW can. It isn't part of raylib's API, it's
+// only there when raylib is built for PLATFORM_DESKTOP_GLFW with its GLFW statically inside
+// (the prebuilt linux and windows libs in libs/ are, their build scripts define this). Any
+// other raylib just sleeps through the wait instead
+#ifdef PLATFORM_DESKTOP_GLFW
+  void glfwWaitEventsTimeout(double timeout);
+#endif
 
 #ifdef __EMSCRIPTEN__
   // Make it lowest resolution people generally use
@@ -44,592 +142,1049 @@ static int highScore = 0;
   static int screenHeight = 0;
 #endif
 
-static int sequence[SEQUENCE_CAPACITY];
-static int sequenceLength = 1;
-static int sequenceDisplayIndex = 0;
+// This is for animations, each button has a size and 4 color channels in here
+static TweenSet buttonTweens;
+static int buttonSizeTweens[BUTTON_AMOUNT];
+static int buttonColorTweens[BUTTON_AMOUNT];
 
-static float sequenceDisplayRateAcceleration = SEQUENCE_DISPLAY_RATE_ACCELERATION;
-static float sequenceDisplayRate = INITIAL_SEQUENCE_DISPLAY_RATE;
-static float sequenceDisplayDelay = 0.f;
+static const Color BUTTON_UNLIT_COLOR = { 200, 200, 200, 255 };
 
-static float runDuration = 0.f;
-static float menuRunDuration = 0.f;
+// Where each button sits from the middle of the screen
+static const Vector2 BUTTON_OFFSETS[BUTTON_AMOUNT] = {
+  { -100.f, 0.f },
+  { 0.f, -100.f },
+  { 100.f, 0.f },
+  { 0.f, 100.f }
+};
 
-static int playerSequence[SEQUENCE_CAPACITY]; 
-static int playerSequenceIndex = 0;
-static int playerSequenceLength = 0;
+static Font font;
+static Shader fontShader;
+
+#define TEXT_SPACING 2
+
+// Text only gets formatted and laid out again when what it shows changes
+static TextLayout menuTitleLayout;
+static TextLayout gameoverTitleLayout;
+static TextLayout winTitleLayout;
+static TextLayout authorLayout;
+static TextLayout counterLayout;
+static TextLayout scoreLayout;
+static TextLayout bestLayout;
+// The menu only changes when the title blinks or the game over title goes away, so it gets
+// drawn into here then and pasted as one quad the rest of the time
+static RenderTexture2D menuLayer;
+static int menuLayerKey = -1;
+static int menuLayerWidth = 0;
+static int menuLayerHeight = 0;
+
+static int shownPlayerSequenceIndex = -1;
+static int shownSequenceLength = -1;
+static int shownScore = -1;
+static int shownHighScore = -1;
 
-static bool buttonsLit[BUTTON_AMOUNT];
-static bool gamepadButtonsDown[BUTTON_AMOUNT];
-static int gamepadButtonPressed = -1;
+static float deltaTime;
+static int savedHighScore = 0;
+static float frameTime;
+static uint64_t lastLoopTime = 0;
+
+// Power save only draws frames that would look different from the last one
+typedef struct FrameState {
+  int width;
+  int height;
+  int gameState;
+  bool buttonsLit[BUTTON_AMOUNT];
+  int menuKey;
+  int playerSequenceIndex;
+  int sequenceLength;
+  int score;
+  int highScore;
+  uint32_t leaderboardChanges;
+} FrameState;
+
+static bool powerSave = false;
+static bool hasDrawnFrame = false;
+static FrameState drawnFrame;
 
-// This is for animations
-static float buttonSizes[BUTTON_AMOUNT];
-static Color buttonColors[BUTTON_AMOUNT];
+//Helpers
+// Where a game clock was at the moment being drawn, resets just snap
+uint64_t RenderClock(uint64_t previous, uint64_t current)
+{
+  if (current < previous)
+    return current;
+  return previous + (uint64_t)((double)(current - previous) * renderAlpha);
+}
 
-static bool isShowingSequence = false;
-static bool isWaitingBetweenButton = false;
-static bool isShowingButtonAnimation = false;
+void ReadSave()
+{
+  printf("Reading savefile at %s\n", SAVEFILE_FILEPATH);
+  SaveData data = { game.highScore };
+  if (SaveRead(SAVEFILE_FILEPATH, &data))
+  {
+    game.highScore = data.highScore;
+  }
+  savedHighScore = game.highScore;
+}
 
-static int animationType;
-enum { ANIMATION_TYPE_GAMEOVER, ANIMATION_TYPE_WIN };
+// Hands the save to the save thread whenever the high score changes, so it's on disk
+// before anyone can pull the plug and the loop never waits for it
+void QueueSave()
+{
+  if (game.highScore == savedHighScore)
+    return;
 
-static int gameoverAnimationBlinkCount = 0;
-static int gameoverBlinkAnimationState = 0;
+  savedHighScore = game.highScore;
+  SaveData data = { game.highScore };
+  SaveThreadQueue(&data);
+}
 
-static int gameState;
-static int gameStateAfterWait;
-static float gameStateWaitDuration;
-static float gameStateWaitRate = 0.f;
-enum {
- GAMESTATE_MENU,
- GAMESTATE_MENU_GAMEOVER,
- GAMESTATE_GAME,
- GAMESTATE_WAITING
-};
+// Input / Drawing
+void ReadInput()
+{
+  InputSample(&inputSnapshot);
+  input = InputToCsimon(&inputSnapshot);
+
+  // Presses from the devices the input thread reads come with its timestamps instead,
+  // raylib only keeps the rest (same as InputToCsimon, highest button wins)
+  uint32_t pressed = InputPressedWithoutThread(&inputSnapshot);
+  input.buttonPressed = -1;
+  for (int i = 0; i < BUTTON_AMOUNT; i++)
+  {
+    if (!(pressed & (1u << (INPUT_SIMON_0 + i))))
+      continue;
+    input.buttonPressed = i;
 
-static const Color BUTTON_UNLIT_COLOR = { 200, 200, 200, 255 };
+    // raylib polls at the end of EndDrawing (or while idling), that's the earliest we could have known
+    if (pendingPressTime[i] == 0)
+      pendingPressTime[i] = lastPollTime;
+  }
+}
 
-static Font fontSm;
-static Font font;
-static Font fontLg;
+// Writes the timeline once per round, as soon as its sequence starts playing
+void WriteTimeline()
+{
+  if (timelineFile == NULL || !game.isShowingSequence || game.gameState != GAMESTATE_GAME)
+    return;
+  if (game.runsFinished == timelineRun && game.sequenceLength == timelineLength)
+    return;
 
-static float deltaTime;
+  timelineRun = game.runsFinished;
+  timelineLength = game.sequenceLength;
 
-//Helpers
-bool IsGamepadButtonDownAny(int button)
+  int edgeCount = CsimonSequenceEdgeCount(&game);
+  for (int i = 0; i < edgeCount; i++)
+  {
+    CsimonSequenceEdge edge = CsimonSequenceEdgeAt(&game, i);
+    fprintf(timelineFile, "%u,%d,%llu,%d,%d\n", game.runsFinished, game.sequenceLength,
+        (unsigned long long)edge.time, edge.button, edge.lit ? 1 : 0);
+  }
+  fflush(timelineFile);
+}
+
+// Stats files are named after the player, so keep the name to things any filesystem takes
+void OpenStats()
 {
-  for (size_t i = 0; i < MAX_CONTROLLER_AMOUNT; i++)
+  char base[STATS_PATH_SIZE];
+  int length = snprintf(base, sizeof(base), "%s", STATS_FILEPATH);
+  for (const char* c = playerName; *c != '\0' && length < (int)sizeof(base) - 1; c++)
   {
-    if (IsGamepadAvailable(i) && IsGamepadButtonDown(i, button))
-      return true;
+    bool allowed = (*c >= 'a' && *c <= 'z') || (*c >= 'A' && *c <= 'Z') || (*c >= '0' && *c <= '9') || *c == '-' || *c == '_';
+    base[length++] = allowed ? *c : '_';
   }
-  return false;
+  base[length] = '\0';
+
+  StatsOpen(&stats, base);
+  statsPressCount = game.pressCount;
+  statsRunsFinished = game.runsFinished;
 }
 
-bool IsGamepadAxisDownAny(int button)
+// Initials for the board: --initials, or the start of the player's name, letters and digits only
+void OpenLeaderboard()
 {
-  for (size_t i = 0; i < MAX_CONTROLLER_AMOUNT; i++)
+  leaderboard = LeaderboardOpen(LEADERBOARD_FILEPATH);
+  shownLeaderboardChanges = leaderboard->changes - 1;
+
+  const char* source = initials;
+  if (source == NULL)
+    source = (strcmp(playerName, "default") != 0) ? playerName : "AAA";
+
+  int length = 0;
+  for (const char* c = source; *c != '\0' && length < LEADERBOARD_INITIALS; c++)
   {
-    if (IsGamepadAvailable(i) && GetGamepadAxisMovement(i, button) > GAMEPAD_AXISREGISTERTHRESHOLD)
-      return true;
+    if ((*c >= 'a' && *c <= 'z') || (*c >= 'A' && *c <= 'Z') || (*c >= '0' && *c <= '9'))
+      runInitials[length++] = (*c >= 'a' && *c <= 'z') ? *c - 'a' + 'A' : *c;
   }
-  return false;
+  if (length == 0)
+    runInitials[length++] = 'A';
+  runInitials[length] = '\0';
 }
 
-static bool prevGamepadAxisState = false;
+bool IsPlaying()
+{
+  return game.gameState == GAMESTATE_GAME ||
+    (game.gameState == GAMESTATE_WAITING && game.gameStateAfterWait == GAMESTATE_GAME);
+}
 
-bool IsGamepadAxisPressedAny(int button)
+void RecordRun(bool wasPlaying, float dt)
 {
-  for (size_t i = 0; i < MAX_CONTROLLER_AMOUNT; i++)
+  // Replays bring their own runs, they don't go on anyone's record
+  if (replayPath != NULL)
+    return;
+
+  if (wasPlaying)
+    statsRun.durationUs += CsimonDtToUs(dt);
+
+  if (game.pressCount != statsPressCount)
   {
-    if (IsGamepadAvailable(i) && GetGamepadAxisMovement(i, button) > GAMEPAD_AXISREGISTERTHRESHOLD)
-    {
-      bool ret = prevGamepadAxisState == false; 
-      prevGamepadAxisState = true;
-      return ret;
-    } else if (GetGamepadAxisMovement(i, button) <= GAMEPAD_AXISREGISTERTHRESHOLD)
+    statsPressCount = game.pressCount;
+    if (statsRun.reactionCount < STATS_MAX_REACTIONS)
+      statsRun.reactionUs[statsRun.reactionCount++] = (game.lastReactionTime < UINT32_MAX) ? (uint32_t)game.lastReactionTime : UINT32_MAX;
+  }
+
+  if (game.runsFinished != statsRunsFinished)
+  {
+    statsRunsFinished = game.runsFinished;
+    statsRun.time = (uint64_t)time(NULL);
+    statsRun.score = game.lastScore;
+    statsRun.length = game.lastLength;
+    StatsAppend(&stats, &statsRun);
+
+    if (statsRun.score > 0 && LeaderboardQualifies(statsRun.score))
     {
-      prevGamepadAxisState = false;
+      LeaderboardEntry entry = { 0 };
+      memcpy(entry.initials, runInitials, sizeof(entry.initials));
+      entry.score = statsRun.score;
+      entry.date = (int64_t)statsRun.time;
+      entry.seed = statsRun.seed;
+      LeaderboardInsert(&entry);
     }
+
+    statsRun.durationUs = 0;
+    statsRun.reactionCount = 0;
   }
-  return false;
 }
 
-bool IsGamepadButtonPressedAny(int button)
+// Every tick the game takes goes through here so it ends up in the recording
+void StepTick(const CsimonInput* tickInput, float dt)
+{
+  previousRunTime = game.runTime;
+  previousMenuTime = game.menuTime;
+
+  // The run's seed gets rerolled the moment it ends
+  bool wasPlaying = IsPlaying();
+  if (wasPlaying)
+    statsRun.seed = game.sequenceSeed;
+
+  ReplayWriterFrame(&replayWriter, &game, tickInput, dt);
+  CsimonStep(&game, tickInput, dt);
+  WriteTimeline();
+  RecordRun(wasPlaying, dt);
+}
+
+// Steps the game up to each timestamped press from the input thread, so presses land
+// when they actually happened instead of on the frame. deltaTime is left as the rest of the frame
+void StepInputThreadPresses()
 {
-  for (size_t i = 0; i < MAX_CONTROLLER_AMOUNT; i++)
+  uint64_t now = InputThreadNow();
+  if (lastStepTime == 0)
+    lastStepTime = now;
+
+  CsimonInput pressInput = input;
+
+  InputEvent event;
+  while (InputThreadPop(&event))
   {
-    if (IsGamepadAvailable(i) && IsGamepadButtonPressed(i, button))
-      return true;
+    if (!event.pressed || event.logical < INPUT_SIMON_0 || event.logical > INPUT_SIMON_3)
+      continue;
+
+    uint64_t time = event.time;
+    if (time < lastStepTime) time = lastStepTime; // Already stepped past it
+    if (time > now) time = now;
+
+    float dt = ReplayQuantizeDt((float)((time - lastStepTime) / 1e9));
+    pressInput.buttonPressed = event.logical - INPUT_SIMON_0;
+    pendingPressTime[pressInput.buttonPressed] = event.time;
+    StepTick(&pressInput, dt);
+
+    pressInput.toggleSequence = false;
+    input.toggleSequence = false;
+    lastStepTime = time;
   }
-  return false;
+
+  deltaTime = ReplayQuantizeDt((float)((now - lastStepTime) / 1e9));
+  lastStepTime = now;
 }
 
-int RandomButton(unsigned int seed)
+// Next press from the input thread that happened before the given time, left queued otherwise
+bool NextThreadPress(uint64_t before, InputEvent* event)
 {
-  srand(time(0) + seed);
-  return rand() % 4;
+  while (hasHeldEvent || InputThreadPop(&heldEvent))
+  {
+    hasHeldEvent = true;
+    if (!heldEvent.pressed || heldEvent.logical < INPUT_SIMON_0 || heldEvent.logical > INPUT_SIMON_3)
+    {
+      hasHeldEvent = false;
+      continue;
+    }
+
+    if (heldEvent.time >= before)
+      return false;
+
+    *event = heldEvent;
+    hasHeldEvent = false;
+    return true;
+  }
+  return false;
 }
 
-void AddButtonToSequence()
+// Runs however many fixed ticks fit in the time since the last frame. Input thread presses
+// go to the tick they happened in, raylib ones to the first tick of the frame
+void StepFixedTicks()
 {
-  sequenceLength++;
-  sequence[sequenceLength-1] = RandomButton(0);
+  uint64_t now = InputThreadNow();
+  if (logicTime == 0 || now - logicTime > FIXED_TICK_MAX_CATCHUP)
+    logicTime = now - tickTime;
+
+  if (input.buttonPressed != -1)
+    carriedPress = input.buttonPressed;
+  if (input.toggleSequence)
+    carriedToggle = true;
+
+  float dt = (float)(tickTime / 1e9);
+  CsimonInput tickInput = input;
+
+  while (now - logicTime >= tickTime)
+  {
+    logicTime += tickTime;
+
+    tickInput.buttonPressed = carriedPress;
+    tickInput.toggleSequence = carriedToggle;
+
+    InputEvent event;
+    if (tickInput.buttonPressed == -1 && NextThreadPress(logicTime, &event))
+    {
+      tickInput.buttonPressed = event.logical - INPUT_SIMON_0;
+      pendingPressTime[tickInput.buttonPressed] = event.time;
+    }
+
+    StepTick(&tickInput, dt);
+    carriedPress = -1;
+    carriedToggle = false;
+  }
+
+  renderAlpha = (float)(now - logicTime) / (float)tickTime;
 }
 
-void ResetButtons()
+// Replays get played back against the clock, however many ticks that takes this frame
+bool StepReplay(float frameTime)
 {
-  for (size_t i = 0; i < BUTTON_AMOUNT; i++)
+  replayLag += frameTime;
+  while (replayLag > 0.0)
   {
-    buttonsLit[i] = false;
-    gamepadButtonsDown[i] = false;
+    if (!ReplayReaderNext(&replayReader, &input, &deltaTime))
+      return false;
+    StepTick(&input, deltaTime);
+    replayLag -= deltaTime;
   }
+  return true;
 }
 
-void LightButtons()
+// Call right after EndDrawing. A press counts as shown on the first frame its button was drawn lit,
+// presses that don't light up by LATENCY_PRESS_TIMEOUT (sequence playing) get dropped
+void RecordLatency(const bool* drawnLit)
 {
-  for (size_t i = 0; i < BUTTON_AMOUNT; i++)
+  uint64_t now = InputThreadNow();
+  if (lastFrameEnd != 0)
+    LatencyAdd(&frameTimes, now - lastFrameEnd);
+  lastFrameEnd = now;
+  lastPollTime = now;
+
+  for (int i = 0; i < BUTTON_AMOUNT; i++)
   {
-    buttonsLit[i] = true;
+    if (pendingPressTime[i] == 0)
+      continue;
+
+    if (drawnLit[i])
+    {
+      LatencyAdd(&pressLatency, now - pendingPressTime[i]);
+      pendingPressTime[i] = 0;
+    } else if (now - pendingPressTime[i] > LATENCY_PRESS_TIMEOUT)
+    {
+      pendingPressTime[i] = 0;
+    }
   }
 }
 
-float LerpFloat(float a, float b, float t)
+void WriteLatencyReport()
 {
-  return a + (b-a) * t;
+  LatencyWriteReport(latencyReportPath != NULL ? latencyReportPath : LATENCY_REPORT_FILEPATH, &pressLatency, &frameTimes);
 }
 
-// We read / writing in binary mode, to prevent skids from editing the savefile
-void WriteSave()
+// The demo is a replay if one was given and loads, the bot otherwise
+void InitAttract()
 {
-  printf("Writing savefile at %s\n", SAVEFILE_FILEPATH);
-  FILE* file = fopen(SAVEFILE_FILEPATH, "wb");
+  if (attractTimeout <= 0.f || replayPath != NULL)
+    return;
 
-  if (file == NULL)
+  if (attractPath != NULL)
   {
-    perror("Error writing savefile");
-    return;
+    attractFromReplay = ReplayReaderOpen(&attractReader, attractPath, &attractGame);
+    if (!attractFromReplay)
+      printf("Couldn't load attract mode demo %s, the bot plays instead\n", attractPath);
   }
+  if (attractFromReplay)
+    return;
 
-  // Add paddings and bit shifts to discourage persistent skids
-  int writeData[] = {
-    10,
-    255,
-    15,
-
-    highScore << 4,
+  CsimonInit(&attractGame);
+  CsimonSeed(&attractGame, (uint64_t)time(NULL));
+  CsimonReset(&attractGame);
+  BotInit(&attractBot, (BotParams){ 0.35f, 12, 0.02f }, ~(uint64_t)time(NULL));
+}
 
-    15,
-    255,
-    10
-  };
-  size_t count = sizeof(writeData) / sizeof(int);
+bool InMenu(const CsimonGame* g)
+{
+  return g->gameState == GAMESTATE_MENU || g->gameState == GAMESTATE_MENU_GAMEOVER;
+}
 
-  size_t writtenCount = fwrite(writeData, sizeof(int), count, file);
+// Streams the replay one tick at a time, looping back to its first keyframe at the end
+void StepAttractReplay(float frameTime)
+{
+  CsimonInput demoInput;
+  float dt;
+  int skipped = 0;
 
-  if (writtenCount != count)
+  attractLag += frameTime;
+  while (attractLag > 0.0)
   {
-    perror("Could not write entire savefile");
+    if (!ReplayReaderNext(&attractReader, &demoInput, &dt))
+    {
+      ReplayReaderSeekRound(&attractReader, 0, &attractGame);
+      attractLag = 0.0;
+      break;
+    }
+
+    // Whoever recorded it standing about in the menu isn't worth watching
+    bool skip = InMenu(&attractGame) && skipped++ < ATTRACT_MAX_SKIP_TICKS;
+    CsimonStep(&attractGame, &demoInput, dt);
+    if (!skip)
+      attractLag -= dt;
   }
-  
-  fclose(file);
 }
 
-void ReadSave()
+// Runs after the real game's tick. Any input at all drops straight out, the real game
+// has had it the whole time so a start press still starts a run on the same frame
+void StepAttract(float frameTime)
 {
-  printf("Reading savefile at %s\n", SAVEFILE_FILEPATH);
-  FILE* file = fopen(SAVEFILE_FILEPATH, "rb");
+  if (attractTimeout <= 0.f || replayPath != NULL)
+    return;
 
-  if (file == NULL)
+  if (!InMenu(&game) || InputAnyActivity(&inputSnapshot))
   {
-    perror("Error reading savefile");
+    attractActive = false;
+    attractIdle = 0.0;
     return;
   }
 
-  int readData[7];
-  size_t count = sizeof(readData) / sizeof(int);
-
-  size_t readCount = fread(readData, sizeof(int), count, file);
-  if (readCount != count)
+  if (!attractActive)
   {
-    perror("Could not read entire savefile, expect your progress not loaded");
+    attractIdle += frameTime;
+    if (attractIdle < attractTimeout)
+      return;
+
+    attractActive = true;
+    attractLag = 0.0;
+    if (attractFromReplay)
+      ReplayReaderSeekRound(&attractReader, 0, &attractGame);
   }
 
-  bool readableSave = true;
-
-  if (readData[0] != 10) readableSave = false;
-  if (readData[1] != 255) readableSave = false;
-  if (readData[2] != 15) readableSave = false;
-  if (readData[4] != 15) readableSave = false;
-  if (readData[5] != 255) readableSave = false;
-  if (readData[6] != 10) readableSave = false;
-
-  if (readableSave)
+  if (attractFromReplay)
   {
-    highScore = readData[3] >> 4;
+    StepAttractReplay(frameTime);
   } else
   {
-    perror("Savefile is corrupt");
+    float dt = ReplayQuantizeDt(frameTime);
+    CsimonInput demoInput = BotThink(&attractBot, &attractGame, dt);
+    CsimonStep(&attractGame, &demoInput, dt);
   }
-
-  fclose(file);
 }
 
-//Reseting
+// The game whose buttons are on screen
+const CsimonGame* ShownGame()
+{
+  return attractActive ? &attractGame : &game;
+}
 
-// Ran whenever player messes up, etc.
-void SoftReset()
+void InitButtonAnimations()
 {
   for (size_t i = 0; i < BUTTON_AMOUNT; i++)
   {
-    buttonSizes[i] = BUTTON_SIZE;
+    buttonSizeTweens[i] = TweenAdd(&buttonTweens, TWEEN_SPRING, BUTTON_SIZE_SPRING_RATE, BUTTON_SIZE);
+
+    buttonColorTweens[i] = TweenAdd(&buttonTweens, TWEEN_EXPONENTIAL, BUTTON_COLOR_RATE, 0.f);
+    TweenAdd(&buttonTweens, TWEEN_EXPONENTIAL, BUTTON_COLOR_RATE, 0.f);
+    TweenAdd(&buttonTweens, TWEEN_EXPONENTIAL, BUTTON_COLOR_RATE, 0.f);
+    TweenAdd(&buttonTweens, TWEEN_EXPONENTIAL, BUTTON_COLOR_RATE, 0.f);
   }
-  for (size_t i = 0; i < SEQUENCE_CAPACITY; i++)
-  {
-    playerSequence[i] = 0;
-  } 
-  playerSequenceLength = 0;
-  playerSequenceIndex = 0;
+}
 
-  isShowingSequence = true;
-  isShowingButtonAnimation = false;
-  sequenceDisplayIndex = 0;
-  sequenceDisplayDelay = 0.f;
+// Uses the real frame time rather than the game's, so animations keep going at the same speed
+// whatever the frame rate, replays and input thread sub steps included
+void StepButtonAnimations(float frameTime)
+{
+  Color targetButtonColors[4];
+  const bool* buttonsLit = ShownGame()->buttonsLit;
+  targetButtonColors[0] = buttonsLit[0] ? GREEN  : BUTTON_UNLIT_COLOR;
+  targetButtonColors[1] = buttonsLit[1] ? BLUE   : BUTTON_UNLIT_COLOR;
+  targetButtonColors[2] = buttonsLit[2] ? RED    : BUTTON_UNLIT_COLOR;
+  targetButtonColors[3] = buttonsLit[3] ? ORANGE : BUTTON_UNLIT_COLOR;
 
-  gameoverAnimationBlinkCount = 0;
-  gameoverBlinkAnimationState = 0;
+  for (size_t i = 0; i < BUTTON_AMOUNT; i++)
+  {
+    buttonTweens.target[buttonSizeTweens[i]] = buttonsLit[i] ? BUTTON_LIT_SIZE : BUTTON_SIZE;
 
-  gameStateWaitDuration = 0.f;
-  gameStateWaitRate = 0.f;
+    float* colorTarget = &buttonTweens.target[buttonColorTweens[i]];
+    colorTarget[0] = targetButtonColors[i].r;
+    colorTarget[1] = targetButtonColors[i].g;
+    colorTarget[2] = targetButtonColors[i].b;
+    colorTarget[3] = targetButtonColors[i].a;
+  }
 
-  menuRunDuration = 0.f;
+  TweenStep(&buttonTweens, frameTime);
 }
 
-// Ran whenever the game boots up / reset
-void Reset()
+Color ButtonColor(int button)
 {
+  const float* channels = &buttonTweens.value[buttonColorTweens[button]];
+  return (Color){
+    (unsigned char)(channels[0] + 0.5f),
+    (unsigned char)(channels[1] + 0.5f),
+    (unsigned char)(channels[2] + 0.5f),
+    (unsigned char)(channels[3] + 0.5f)
+  };
+}
 
-  ResetButtons();
+void DrawButtons()
+{
+  for (size_t i = 0; i < BUTTON_AMOUNT; i++)
+  {
+    Vector2 center = { screenWidth/2 + BUTTON_OFFSETS[i].x, screenHeight/2 + BUTTON_OFFSETS[i].y };
+    AddCircle(center, buttonTweens.value[buttonSizeTweens[i]], 0.f, ButtonColor((int)i));
+  }
+  DrawCircleBatch();
+}
 
-  score = 0;
+void LayoutMenu()
+{
+  TextLayoutSet(&menuTitleLayout, font, MENU_TITLE, (float)FONT_SIZE_LG, TEXT_SPACING);
+  TextLayoutSet(&gameoverTitleLayout, font, GAMEOVER_TITLE, (float)FONT_SIZE, TEXT_SPACING);
+  TextLayoutSet(&winTitleLayout, font, WIN_TITLE, (float)FONT_SIZE, TEXT_SPACING);
+  TextLayoutSet(&authorLayout, font, AUTHOR, (float)FONT_SIZE_SM, TEXT_SPACING);
+}
 
-  runDuration = 0.f;
+// One row per entry, left aligned in a column against the right edge
+void LayoutLeaderboard()
+{
+  char buf[TEXT_LAYOUT_MAX_LENGTH];
+  char date[16];
 
-  for (size_t i = 0; i < SEQUENCE_CAPACITY; i++)
+  leaderboardWidth = 0.f;
+  for (uint32_t i = 0; i < leaderboard->count; i++)
   {
-    sequence[i] = 0;
-    playerSequence[i] = 0;
+    const LeaderboardEntry* entry = &leaderboard->entries[i];
+    time_t entryDate = (time_t)entry->date;
+    struct tm* local = localtime(&entryDate);
+    if (local == NULL || strftime(date, sizeof(date), "%Y-%m-%d", local) == 0)
+      date[0] = '\0';
+
+    snprintf(buf, sizeof(buf), "%2u. %-3s %5d  %s", (unsigned int)i + 1, entry->initials, (int)entry->score, date);
+    TextLayoutSet(&leaderboardLayouts[i], font, buf, (float)FONT_SIZE_SM, TEXT_SPACING);
+    if (leaderboardLayouts[i].dimensions.x > leaderboardWidth)
+      leaderboardWidth = leaderboardLayouts[i].dimensions.x;
   }
-  sequenceLength = 1;
+  shownLeaderboardChanges = leaderboard->changes;
+}
 
-  playerSequenceLength = 0;
-  playerSequenceIndex = 0;
+void DrawLeaderboard()
+{
+  for (uint32_t i = 0; i < leaderboard->count; i++)
+  {
+    DrawTextLayout(&leaderboardLayouts[i], (Vector2){
+        (float)screenWidth - leaderboardWidth - 10.f,
+        10.f + (float)i * (FONT_SIZE_SM + 4.f)
+        }, DARKGRAY);
+  }
+}
 
-  for (size_t i = 0; i < sequenceLength; i++)
+void DrawMenuText(bool showResult, bool showTitle)
+{
+  if (showResult)
   {
-    sequence[i] = RandomButton(i*100);
+    const TextLayout* title = (game.animationType == ANIMATION_TYPE_WIN) ? &winTitleLayout : &gameoverTitleLayout;
+    DrawTextLayout(title, (Vector2){
+          (float)(screenWidth/2 - title->dimensions.x/2),
+          (float)(screenHeight/2 + 30.f)
+        }, DARKGRAY);
   }
 
-  ResetButtons(); 
-  SoftReset();
+  if (showTitle)
+  {
+    DrawTextLayout(&menuTitleLayout, (Vector2){
+        (float)(screenWidth/2 - menuTitleLayout.dimensions.x/2),
+        (float)(screenHeight/2 - FONT_SIZE_LG/2)
+        }, DARKGRAY);
+  }
 
-  sequenceDisplayRate = INITIAL_SEQUENCE_DISPLAY_RATE;
-  sequenceDisplayRateAcceleration = SEQUENCE_DISPLAY_RATE_ACCELERATION;
+  DrawTextLayout(&authorLayout, (Vector2){
+      (float)(screenWidth/2 - authorLayout.dimensions.x/2),
+      (float)(screenHeight - FONT_SIZE_SM) - 10.f
+      }, DARKGRAY);
 
-  gameState = GAMESTATE_MENU;
-  gameStateAfterWait = GAMESTATE_MENU;
+  DrawLeaderboard();
 }
 
-// Input / Drawing
-void DrawButtons()
+// Everything that decides what the menu layer looks like, in one number
+int MenuLayerKey(bool isGameoverMenu, bool* showResult, bool* showTitle)
 {
-  //Jank af
-#ifdef __EMSCRIPTEN__
-  gamepadButtonsDown[1] = IsGamepadButtonDownAny(GAMEPAD_BUTTON_RIGHT_FACE_LEFT);  // X
-  gamepadButtonsDown[0] = IsGamepadButtonDownAny(GAMEPAD_BUTTON_RIGHT_FACE_UP);    // Y
-#else
-  gamepadButtonsDown[0] = IsGamepadButtonDownAny(GAMEPAD_BUTTON_RIGHT_FACE_LEFT) ||
-    IsGamepadButtonDownAny(GAMEPAD_BUTTON_RIGHT_TRIGGER_1);  // X / RShoulder
-  gamepadButtonsDown[1] = IsGamepadButtonDownAny(GAMEPAD_BUTTON_RIGHT_FACE_UP) ||
-    IsGamepadAxisDownAny(GAMEPAD_AXIS_LEFT_TRIGGER);    // Y / LTrigger
-#endif
-  gamepadButtonsDown[2] = IsGamepadButtonDownAny(GAMEPAD_BUTTON_RIGHT_FACE_RIGHT); // B
-  gamepadButtonsDown[3] = IsGamepadButtonDownAny(GAMEPAD_BUTTON_RIGHT_FACE_DOWN);  // A
+  *showResult = isGameoverMenu && RenderClock(previousMenuTime, game.menuTime) < MENU_RESULT_TIME;
+  *showTitle = (RenderClock(previousRunTime, game.runTime) * 15 / CSIMON_US_PER_SECOND) % 15 > 7;
+  return (*showResult ? 1 + game.animationType : 0) * 2 + (*showTitle ? 1 : 0);
+}
 
-  if (!gamepadButtonsDown[0]) gamepadButtonsDown[0] = IsKeyDown(KEY_LEFT);
-  if (!gamepadButtonsDown[1]) gamepadButtonsDown[1] = IsKeyDown(KEY_UP);
-  if (!gamepadButtonsDown[2]) gamepadButtonsDown[2] = IsKeyDown(KEY_RIGHT);
-  if (!gamepadButtonsDown[3]) gamepadButtonsDown[3] = IsKeyDown(KEY_DOWN);
+// Call outside BeginDrawing, redraws the menu layer if what's on it changed
+void UpdateMenuLayer(bool isGameoverMenu)
+{
+  bool showResult;
+  bool showTitle;
+  int key = MenuLayerKey(isGameoverMenu, &showResult, &showTitle);
 
-  
-  gamepadButtonPressed = -1;
-#ifdef __EMSCRIPTEN__
-  if (IsGamepadButtonPressedAny(GAMEPAD_BUTTON_RIGHT_FACE_LEFT)) gamepadButtonPressed = 1;
-  if (IsGamepadButtonPressedAny(GAMEPAD_BUTTON_RIGHT_FACE_UP)) gamepadButtonPressed = 0;
-#else
-  if (IsGamepadButtonPressedAny(GAMEPAD_BUTTON_RIGHT_FACE_LEFT) ||
-      IsGamepadButtonPressedAny(GAMEPAD_BUTTON_RIGHT_TRIGGER_1)) gamepadButtonPressed = 0;
-  if (IsGamepadButtonPressedAny(GAMEPAD_BUTTON_RIGHT_FACE_UP) ||
-      IsGamepadAxisPressedAny(GAMEPAD_AXIS_LEFT_TRIGGER)) gamepadButtonPressed = 1;
-#endif
-  if (IsGamepadButtonPressedAny(GAMEPAD_BUTTON_RIGHT_FACE_RIGHT)) gamepadButtonPressed = 2;
-  if (IsGamepadButtonPressedAny(GAMEPAD_BUTTON_RIGHT_FACE_DOWN)) gamepadButtonPressed = 3;
+  if (menuLayer.id == 0 || menuLayerWidth != screenWidth || menuLayerHeight != screenHeight)
+  {
+    UnloadRenderTexture(menuLayer);
+    menuLayer = LoadRenderTexture(screenWidth, screenHeight);
+    menuLayerWidth = screenWidth;
+    menuLayerHeight = screenHeight;
+    menuLayerKey = -1;
+  }
 
-  if (IsKeyPressed(KEY_LEFT)) gamepadButtonPressed = 0;
-  if (IsKeyPressed(KEY_UP)) gamepadButtonPressed = 1;
-  if (IsKeyPressed(KEY_RIGHT)) gamepadButtonPressed = 2;
-  if (IsKeyPressed(KEY_DOWN)) gamepadButtonPressed = 3;
+  if (leaderboard->changes != shownLeaderboardChanges)
+  {
+    LayoutLeaderboard();
+    menuLayerKey = -1;
+  }
 
+  if (key == menuLayerKey)
+    return;
+  menuLayerKey = key;
+
+  BeginTextureMode(menuLayer);
+  ClearBackground(BLANK);
+
+  // Premultiplied, with the alpha added up properly instead of squared, so it pastes
+  // back over the buttons looking the same as drawing the text straight there
+  rlSetBlendFactorsSeparate(RL_SRC_ALPHA, RL_ONE_MINUS_SRC_ALPHA, RL_ONE, RL_ONE_MINUS_SRC_ALPHA, RL_FUNC_ADD, RL_FUNC_ADD);
+  BeginBlendMode(BLEND_CUSTOM_SEPARATE);
+  BeginShaderMode(fontShader);
+  DrawMenuText(showResult, showTitle);
+  EndShaderMode();
+  EndBlendMode();
+
+  EndTextureMode();
+}
 
-  if (
-      (!isShowingSequence && !isShowingButtonAnimation) ||
-      (gameState == GAMESTATE_WAITING && !isShowingSequence)
-     )
+void DrawMenuLayer()
+{
+  BeginBlendMode(BLEND_ALPHA_PREMULTIPLY);
+  // Render textures come out upside down
+  DrawTextureRec(menuLayer.texture, (Rectangle){ 0.f, 0.f, (float)menuLayerWidth, -(float)menuLayerHeight }, (Vector2){ 0.f, 0.f }, WHITE);
+  EndBlendMode();
+}
+
+void DrawHud()
+{
+  char buf[TEXT_LAYOUT_MAX_LENGTH];
+
+  if (game.gameState != GAMESTATE_MENU && game.gameState != GAMESTATE_MENU_GAMEOVER)
   {
-    for (size_t i = 0; i < BUTTON_AMOUNT; i++)
+    if (game.playerSequenceIndex != shownPlayerSequenceIndex || game.sequenceLength != shownSequenceLength)
     {
-      buttonsLit[i] = gamepadButtonsDown[i];
+      shownPlayerSequenceIndex = game.playerSequenceIndex;
+      shownSequenceLength = game.sequenceLength;
+      snprintf(buf, sizeof(buf), "%d/%d", game.playerSequenceIndex, game.sequenceLength);
+      TextLayoutSet(&counterLayout, font, buf, (float)FONT_SIZE, TEXT_SPACING);
     }
+    DrawTextLayout(&counterLayout, (Vector2){ (float)(screenWidth / 2 - counterLayout.dimensions.x / 2), (float)(screenHeight - 100) }, DARKGRAY);
   }
 
-  Color targetButtonColors[4];
-  targetButtonColors[0] = buttonsLit[0] ? GREEN  : BUTTON_UNLIT_COLOR;
-  targetButtonColors[1] = buttonsLit[1] ? BLUE   : BUTTON_UNLIT_COLOR;
-  targetButtonColors[2] = buttonsLit[2] ? RED    : BUTTON_UNLIT_COLOR;
-  targetButtonColors[3] = buttonsLit[3] ? ORANGE : BUTTON_UNLIT_COLOR;
-
-  buttonColors[0] = ColorLerp(buttonColors[0], targetButtonColors[0], BUTTON_COLOR_INTERPOLATION);
-  buttonColors[1] = ColorLerp(buttonColors[1], targetButtonColors[1], BUTTON_COLOR_INTERPOLATION);
-  buttonColors[2] = ColorLerp(buttonColors[2], targetButtonColors[2], BUTTON_COLOR_INTERPOLATION);
-  buttonColors[3] = ColorLerp(buttonColors[3], targetButtonColors[3], BUTTON_COLOR_INTERPOLATION);
-
-  float targetButtonSizes[4];
-  targetButtonSizes[0] = buttonsLit[0] ? BUTTON_LIT_SIZE : BUTTON_SIZE;
-  targetButtonSizes[1] = buttonsLit[1] ? BUTTON_LIT_SIZE : BUTTON_SIZE;
-  targetButtonSizes[2] = buttonsLit[2] ? BUTTON_LIT_SIZE : BUTTON_SIZE;
-  targetButtonSizes[3] = buttonsLit[3] ? BUTTON_LIT_SIZE : BUTTON_SIZE;
+  if (game.score != shownScore)
+  {
+    shownScore = game.score;
+    snprintf(buf, sizeof(buf), SCORE_LABEL "%d", game.score);
+    TextLayoutSet(&scoreLayout, font, buf, (float)FONT_SIZE_SM, TEXT_SPACING);
+  }
+  DrawTextLayout(&scoreLayout, (Vector2){ 10.f, 10.f }, DARKGRAY);
 
-  buttonSizes[0] = LerpFloat(buttonSizes[0], targetButtonSizes[0], BUTTON_SIZE_INTERPOLATION);
-  buttonSizes[1] = LerpFloat(buttonSizes[1], targetButtonSizes[1], BUTTON_SIZE_INTERPOLATION);
-  buttonSizes[2] = LerpFloat(buttonSizes[2], targetButtonSizes[2], BUTTON_SIZE_INTERPOLATION);
-  buttonSizes[3] = LerpFloat(buttonSizes[3], targetButtonSizes[3], BUTTON_SIZE_INTERPOLATION);
+  if (game.highScore != shownHighScore)
+  {
+    shownHighScore = game.highScore;
+    snprintf(buf, sizeof(buf), BEST_LABEL "%d", game.highScore);
+    TextLayoutSet(&bestLayout, font, buf, (float)FONT_SIZE_SM, TEXT_SPACING);
+  }
+  DrawTextLayout(&bestLayout, (Vector2){ 10.0f, 30.0f }, DARKGRAY);
+}
 
-  DrawCircle(screenWidth/2 - 100, screenHeight/2, buttonSizes[0], buttonColors[0]);
-  DrawCircle(screenWidth/2, screenHeight/2 - 100, buttonSizes[1], buttonColors[1]);
-  DrawCircle(screenWidth/2 + 100, screenHeight/2, buttonSizes[2], buttonColors[2]);
-  DrawCircle(screenWidth/2, screenHeight/2 + 100, buttonSizes[3], buttonColors[3]);
+FrameState CurrentFrameState()
+{
+  FrameState frame;
+  memset(&frame, 0, sizeof(frame)); // Compared with memcmp, padding included
+  frame.width = screenWidth;
+  frame.height = screenHeight;
+  frame.gameState = game.gameState;
+  memcpy(frame.buttonsLit, ShownGame()->buttonsLit, sizeof(frame.buttonsLit));
+
+  bool showResult;
+  bool showTitle;
+  bool inMenu = game.gameState == GAMESTATE_MENU || game.gameState == GAMESTATE_MENU_GAMEOVER;
+  frame.menuKey = inMenu ? MenuLayerKey(game.gameState == GAMESTATE_MENU_GAMEOVER, &showResult, &showTitle) : -1;
+
+  frame.playerSequenceIndex = game.playerSequenceIndex;
+  frame.sequenceLength = game.sequenceLength;
+  frame.score = game.score;
+  frame.highScore = game.highScore;
+  frame.leaderboardChanges = leaderboard->changes;
+  return frame;
 }
 
-void DrawMenu(bool isGameoverMenu)
+// Seconds until something on screen changes by itself, negative if only input can change it
+double TimeToNextVisualEvent()
 {
-  menuRunDuration += GetFrameTime();
-  if (
-    IsGamepadButtonDownAny(GAMEPAD_BUTTON_MIDDLE_RIGHT) ||
-    IsKeyDown(KEY_ENTER) )
+  double next = -1.0;
+  #define CONSIDER(seconds) do { double at = (seconds); if (next < 0.0 || at < next) next = at; } while (0)
+
+  switch (game.gameState)
   {
-    gameState = GAMESTATE_GAME;
+    case GAMESTATE_MENU:
+    case GAMESTATE_MENU_GAMEOVER:
+    {
+      // Title blink, lit from 8/15 to 15/15 of every second. Phase is in 15ths of a microsecond
+      uint64_t phase = game.runTime * 15 % (15 * CSIMON_US_PER_SECOND);
+      uint64_t edge = (phase < 8 * CSIMON_US_PER_SECOND) ? 8 * CSIMON_US_PER_SECOND : 15 * CSIMON_US_PER_SECOND;
+      CONSIDER((edge - phase) / 15e6);
+      if (game.gameState == GAMESTATE_MENU_GAMEOVER && game.menuTime < MENU_RESULT_TIME)
+        CONSIDER((MENU_RESULT_TIME - game.menuTime) / 1e6);
+      break;
+    }
+
+    case GAMESTATE_WAITING:
+      if (game.gameStateWaitTime <= game.gameStateWaitDuration)
+        CONSIDER((game.gameStateWaitDuration - game.gameStateWaitTime) / 1e6);
+      break;
+
+    case GAMESTATE_GAME:
+      if (game.isShowingSequence)
+      {
+        int edge = CsimonSequenceNextEdge(&game);
+        uint64_t edgeTime = (edge < CsimonSequenceEdgeCount(&game)) ? CsimonSequenceEdgeAt(&game, edge).time : CsimonSequenceDuration(&game);
+        CONSIDER((edgeTime - game.sequenceTime) / 1e6);
+      }
+      break;
   }
 
-  if (isGameoverMenu && menuRunDuration < 3.f)
+  if (game.isShowingButtonAnimation)
   {
-    Vector2 gameOverTitleDimensions = MeasureTextEx(font, GAMEOVER_TITLE, (float)font.baseSize, 2);  
-    DrawTextEx(font, GAMEOVER_TITLE, (Vector2){
-          (float)(screenWidth/2 - gameOverTitleDimensions.x/2),
-          (float)(screenHeight/2 + 30.f)
-        }, (float)font.baseSize, 2, DARKGRAY);
+    // Blinking on for 2/5 and off for 1/5 of a second, phase in 5ths of a microsecond
+    uint64_t phase = game.runTime * 5 % (3 * CSIMON_US_PER_SECOND);
+    uint64_t edge = (phase < 2 * CSIMON_US_PER_SECOND) ? 2 * CSIMON_US_PER_SECOND : 3 * CSIMON_US_PER_SECOND;
+    CONSIDER((edge - phase) / 5e6);
   }
 
-  if ((int)(runDuration * 15.f) % 15 > 7)
+  // The demo moves by itself, and it starting is worth waking up for too
+  if (attractActive)
+    CONSIDER(POWER_SAVE_POLL_INTERVAL);
+  else if (attractTimeout > 0.f && replayPath == NULL && InMenu(&game))
+    CONSIDER(attractTimeout - attractIdle);
+
+  #undef CONSIDER
+  return next;
+}
+
+// Sleeps until the next thing that would change the screen, or input. Gamepads and the input
+// thread can't wake raylib up, so with either of those around it wakes up to poll now and then
+void IdleUntilNextEvent()
+{
+  double wait = TimeToNextVisualEvent();
+  bool canBlock = !InputThreadRunning() && (inputSnapshot.connected & ~(1u << INPUT_KEYBOARD_SLOT)) == 0;
+
+  if (wait < 0.0 && canBlock)
+  {
+    EnableEventWaiting();
+    PollInputEvents();
+    DisableEventWaiting();
+  } else if (canBlock)
   {
-    Vector2 menuTitleDimensions = MeasureTextEx(fontLg, MENU_TITLE, (float)fontLg.baseSize, 2);
-    DrawTextEx(fontLg, MENU_TITLE, (Vector2){
-        (float)(screenWidth/2 - menuTitleDimensions.x/2),
-        (float)(screenHeight/2 - fontLg.baseSize/2)
-        }, (float)fontLg.baseSize, 2, DARKGRAY);
+#ifdef PLATFORM_DESKTOP_GLFW
+    // Keys and the window still wake it up early, their callbacks fill in raylib's state
+    PollInputEvents();
+    glfwWaitEventsTimeout(wait);
+#else
+    WaitTime(wait);
+    PollInputEvents();
+#endif
+  } else
+  {
+    if (wait < 0.0 || wait > POWER_SAVE_POLL_INTERVAL)
+      wait = POWER_SAVE_POLL_INTERVAL;
+    WaitTime(wait);
+    PollInputEvents();
   }
 
-  Vector2 creditDimensions = MeasureTextEx(fontSm, AUTHOR, (float)fontSm.baseSize, 2);
-  DrawTextEx(fontSm, AUTHOR, (Vector2){
-      (float)(screenWidth/2 - creditDimensions.x/2),
-      (float)(screenHeight - fontSm.baseSize) - 10.f
-      }, (float)fontSm.baseSize, 2, DARKGRAY);
+  lastPollTime = InputThreadNow();
+  lastFrameEnd = 0;
+}
+
+void ParseArgs(int argc, char** argv)
+{
+  for (int i = 1; i < argc; i++)
+  {
+    if (strcmp(argv[i], "--marathon") == 0)
+    {
+      game.marathon = true;
+    } else if (strcmp(argv[i], "--start") == 0 && i + 1 < argc)
+    {
+      CsimonSetStartLength(&game, atoi(argv[++i]));
+    } else if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc)
+    {
+      CsimonSeed(&game, strtoull(argv[++i], NULL, 10));
+    } else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc)
+    {
+      recordPath = argv[++i];
+    } else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc)
+    {
+      replayPath = argv[++i];
+    } else if (strcmp(argv[i], "--replay-round") == 0 && i + 1 < argc)
+    {
+      replayRound = atol(argv[++i]);
+    } else if (strcmp(argv[i], "--input-map") == 0 && i + 1 < argc)
+    {
+      inputMapPath = argv[++i];
+    } else if (strcmp(argv[i], "--input-profile") == 0 && i + 1 < argc)
+    {
+      inputProfile = argv[++i];
+    } else if (strcmp(argv[i], "--input-thread") == 0)
+    {
+      useInputThread = true;
+    } else if (strcmp(argv[i], "--timeline") == 0 && i + 1 < argc)
+    {
+      timelinePath = argv[++i];
+    } else if (strcmp(argv[i], "--tick-rate") == 0 && i + 1 < argc)
+    {
+      tickRate = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--fps") == 0 && i + 1 < argc)
+    {
+      targetFps = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--vsync") == 0)
+    {
+      useVsync = true;
+    } else if (strcmp(argv[i], "--power-save") == 0)
+    {
+      powerSave = true;
+    } else if (strcmp(argv[i], "--latency-report") == 0 && i + 1 < argc)
+    {
+      latencyReportPath = argv[++i];
+    } else if (strcmp(argv[i], "--player") == 0 && i + 1 < argc)
+    {
+      playerName = argv[++i];
+    } else if (strcmp(argv[i], "--initials") == 0 && i + 1 < argc)
+    {
+      initials = argv[++i];
+    } else if (strcmp(argv[i], "--attract") == 0 && i + 1 < argc)
+    {
+      attractPath = argv[++i];
+    } else if (strcmp(argv[i], "--attract-timeout") == 0 && i + 1 < argc)
+    {
+      attractTimeout = (float)atof(argv[++i]);
+    } else if (strcmp(argv[i], "--stats-report") == 0 && i + 1 < argc)
+    {
+      statsReportPath = argv[++i];
+    } else
+    {
+      printf("Unknown argument %s\n", argv[i]);
+    }
+  }
 }
 
 // Logic
-int main(void)
+int main(int argc, char** argv)
 {
-    Reset();
+    CsimonInit(&game);
+    CsimonSeed(&game, (uint64_t)time(NULL));
+    ParseArgs(argc, argv);
+    CsimonReset(&game);
+
+    if (timelinePath != NULL)
+    {
+      timelineFile = fopen(timelinePath, "w");
+      if (timelineFile == NULL)
+        perror("Error opening timeline file");
+      else
+        fprintf(timelineFile, "run,length,time_us,button,lit\n");
+    }
+
+    InputInit();
+    InputLoadMap(inputMapPath);
+    if (inputProfile != NULL && !InputUseProfile(inputProfile))
+    {
+      printf("No input profile called %s, using default\n", inputProfile);
+    }
+
+    if (replayPath != NULL)
+    {
+      if (!ReplayReaderOpen(&replayReader, replayPath, &game))
+        return 1;
+      if (replayRound >= 0)
+        ReplayReaderSeekRound(&replayReader, (uint64_t)replayRound, &game);
+    }
+
+    InitButtonAnimations();
+    InitAttract();
+
+    if (tickRate > 0)
+    {
+      // Whole microseconds so the ticks match what replays store
+      tickTime = CsimonDtToUs(ReplayQuantizeDt(1.f / (float)tickRate)) * 1000ull;
+      if (tickTime == 0) tickTime = 1000;
+    }
 
-    SetConfigFlags(FLAG_MSAA_4X_HINT);
+    // No MSAA, the only thing that needed it was the buttons and they antialias themselves now
+    SetConfigFlags(useVsync ? FLAG_VSYNC_HINT : 0);
     InitWindow(screenWidth, screenHeight, APP_TITLE);
 
     screenWidth = GetRenderWidth();
     screenHeight = GetRenderHeight();
 
-    SetTargetFPS(60);               
+    SetTargetFPS(targetFps); // 0 is uncapped               
     HideCursor();
 
     SetWindowState(FLAG_FULLSCREEN_MODE);
 
-    ReadSave();
+    // Replays bring their own high score, don't let them touch the real one
+    if (replayPath == NULL)
+    {
+      ReadSave();
+      SaveThreadStart(SAVEFILE_FILEPATH);
+      OpenStats();
+      if (recordPath != NULL)
+        ReplayWriterOpen(&replayWriter, recordPath, &game);
+      if (useInputThread)
+        InputThreadStart();
+    }
+
+    OpenLeaderboard();
+    // The board outlives any old save that didn't know about it
+    if (replayPath == NULL && leaderboard->count > 0 && leaderboard->entries[0].score > game.highScore)
+      game.highScore = leaderboard->entries[0].score;
 
-    font = LoadFontFromMemory(".ttf", RobotoRegular, RobotoRegular_len, 30, 0, 0);
-    fontSm = LoadFontFromMemory(".ttf", RobotoRegular, RobotoRegular_len, 20, 0, 0);
-    fontLg = LoadFontFromMemory(".ttf", RobotoRegular, RobotoRegular_len, 50, 0, 0);
+    font = LoadBakedFont();
+    fontShader = LoadBakedFontShader();
+    LayoutMenu();
+    LoadCircleRenderer();
 
     
     while (!WindowShouldClose())    
     {
       //DrawFPS(10, screenHeight - 50);
-      char buf[100];
-      deltaTime = GetFrameTime();
-      runDuration += deltaTime;
 
-      BeginDrawing();
-      ClearBackground(RAYWHITE);
-      DrawButtons();
-
-      if (IsKeyPressed(KEY_ZERO))
-      {
-        isShowingSequence = !isShowingSequence;
-      }
+      // Our own clock, GetFrameTime only moves when a frame gets drawn
+      uint64_t loopTime = InputThreadNow();
+      frameTime = (lastLoopTime != 0) ? (float)((loopTime - lastLoopTime) / 1e9) : 0.f;
+      lastLoopTime = loopTime;
+      deltaTime = ReplayQuantizeDt(frameTime);
 
-      switch (gameState)
+      if (replayPath != NULL)
       {
-        case GAMESTATE_GAME:
-          if (isShowingSequence && !isShowingButtonAnimation)
-          {
-            sequenceDisplayDelay += (!isWaitingBetweenButton) ? deltaTime * OFF_TO_ON_SHOWING_SEQUENCE_RATIO : deltaTime;
-
-            if (sequenceDisplayDelay > sequenceDisplayRate)
-            {
-              sequenceDisplayDelay = 0.f;
-
-              if (sequenceDisplayIndex < sequenceLength)
-              {
-                if (isWaitingBetweenButton)
-                {
-                  ResetButtons();
-                  isWaitingBetweenButton = false;
-                } else
-                {
-                  buttonsLit[sequence[sequenceDisplayIndex]] = true;
-                  isWaitingBetweenButton = true;
-
-                  sequenceDisplayIndex++;
-                }
-              } else
-              {
-                sequenceDisplayIndex = 0;
-                playerSequenceIndex = 0;
-                isShowingSequence = false;
-              }
-            }
-          } else if (!isShowingButtonAnimation)
-          {
-            if (gamepadButtonPressed != -1)
-            {
-              if (gamepadButtonPressed == sequence[playerSequenceIndex])
-              {
-                playerSequenceIndex++;
-
-                if (playerSequenceIndex >= sequenceLength)
-                {
-                  if (sequenceDisplayRate > 0.3f)
-                  {
-                    sequenceDisplayRate -= sequenceDisplayRateAcceleration;
-                  }
-                  if (sequenceDisplayRateAcceleration > 0.f)
-                  {
-                    sequenceDisplayRateAcceleration -= SEQUENCE_DISPLAY_RATE_ACCELERATION_DECCELERATION;
-                  }
-                  if (sequenceDisplayRateAcceleration < 0.f)
-                  {
-                    sequenceDisplayRateAcceleration = 0.f;
-                  }
-                  score += playerSequenceIndex;
-                  SoftReset(); 
-                  AddButtonToSequence();
-
-                  gameState = GAMESTATE_WAITING;
-                  gameStateAfterWait = GAMESTATE_GAME;
-                  gameStateWaitDuration = 0.2f;
-                }
-              } else
-              {
-                Reset();
-                gameState = GAMESTATE_WAITING;
-                gameStateAfterWait = GAMESTATE_MENU_GAMEOVER;
-                gameStateWaitDuration = 2.f;
-                isShowingButtonAnimation = true;
-                animationType = ANIMATION_TYPE_GAMEOVER;
-              }
-            }
-          }
-
-          if (score > highScore)
-          {
-            highScore = score;
-          }
-
-          break;
-
-        case GAMESTATE_WAITING:
-          gameStateWaitRate += deltaTime;
-          if (gameStateWaitRate > gameStateWaitDuration)
-          {
-            gameStateWaitDuration = 0;
-            gameStateWaitRate = 0;
-            gameState = gameStateAfterWait;
-            playerSequenceIndex = 0;
-            ResetButtons();
-          } 
-          break;
-
-        case GAMESTATE_MENU:
-          DrawMenu(false);
-          break;
-        case GAMESTATE_MENU_GAMEOVER:
-          DrawMenu(true); 
+        if (!StepReplay(frameTime))
           break;
-
-      }
-
-      if (gameState != GAMESTATE_MENU && gameState != GAMESTATE_MENU_GAMEOVER)
+      } else if (tickRate > 0)
+      {
+        ReadInput();
+        StepFixedTicks();
+      } else
       {
-        snprintf(buf, sizeof(buf), "%d/%d", playerSequenceIndex, sequenceLength);
-        Vector2 texDimensions = MeasureTextEx(font, buf, (float)font.baseSize, 2);
-        DrawTextEx(font, buf, (Vector2){ (float)(screenWidth / 2 - texDimensions.x / 2), (float)(screenHeight - 100) }, (float)font.baseSize, 2, DARKGRAY);
+        ReadInput();
+        if (InputThreadRunning())
+          StepInputThreadPresses();
+        StepTick(&input, deltaTime);
       }
+      StepAttract(frameTime);
+      StepButtonAnimations(frameTime);
 
-      snprintf(buf, sizeof(buf), "Score: %d", score);
-      DrawTextEx(fontSm, buf, (Vector2){ 10.f, 10.f }, (float)fontSm.baseSize, 2, DARKGRAY);
+      if (replayPath == NULL)
+        QueueSave();
 
-      snprintf(buf, sizeof(buf), "Best: %d", highScore);
-      DrawTextEx(fontSm, buf, (Vector2){ 10.0f, 30.0f }, (float)fontSm.baseSize, 2, DARKGRAY);
+      if (InputPressedAny(&inputSnapshot, INPUT_LATENCY_REPORT))
+        WriteLatencyReport();
 
+      if (InputDownAny(&inputSnapshot, INPUT_QUIT))
+        break;
 
-      if (isShowingButtonAnimation)
+      // Replays change every tick, there's nothing to save there
+      if (powerSave && replayPath == NULL)
       {
-        if (animationType == ANIMATION_TYPE_GAMEOVER)
+        bool settled = TweenSettle(&buttonTweens, POWER_SAVE_SETTLE_EPSILON);
+        FrameState frame = CurrentFrameState();
+        if (settled && hasDrawnFrame && memcmp(&frame, &drawnFrame, sizeof(frame)) == 0)
         {
-          if ((int)(runDuration*5.f) % 3 < 2) 
-          {
-            if (gameoverBlinkAnimationState)
-            {
-              gameoverAnimationBlinkCount++;
-            }
-            LightButtons();
-            gameoverBlinkAnimationState = 0;
-          } else
-          {
-            gameoverBlinkAnimationState = 1;
-            ResetButtons();
-
-            if (gameoverAnimationBlinkCount >= GAMEOVER_BLINK_AMOUNT-1)
-            {
-              gameState = GAMESTATE_MENU_GAMEOVER;
-              gameStateWaitRate = 0.f;
-              gameoverBlinkAnimationState = 0;
-              gameoverAnimationBlinkCount = 0;
-              isShowingButtonAnimation = false;
-            }
-          }
+          IdleUntilNextEvent();
+          continue;
         }
+        drawnFrame = frame;
+        hasDrawnFrame = true;
       }
 
-      EndDrawing();
+      bool inMenu = game.gameState == GAMESTATE_MENU || game.gameState == GAMESTATE_MENU_GAMEOVER;
+      if (inMenu)
+        UpdateMenuLayer(game.gameState == GAMESTATE_MENU_GAMEOVER);
 
-      if (IsGamepadButtonDownAny(GAMEPAD_BUTTON_MIDDLE_LEFT))
-        break;
-    }
+      BeginDrawing();
+      ClearBackground(RAYWHITE);
+      DrawButtons();
 
-    WriteSave();
+      if (inMenu)
+        DrawMenuLayer();
 
+      // All the other text goes out in one batch with the SDF shader
+      BeginShaderMode(fontShader);
+      DrawHud();
+
+      EndShaderMode();
+
+      bool drawnLit[BUTTON_AMOUNT];
+      memcpy(drawnLit, ShownGame()->buttonsLit, sizeof(drawnLit));
+
+      EndDrawing();
+      RecordLatency(drawnLit);
+    }
+
+    if (replayPath == NULL)
+    {
+      QueueSave();
+      SaveThreadStop();
+      StatsClose(&stats);
+      if (statsReportPath != NULL)
+        StatsWriteReport(statsReportPath, playerName, &stats.summary);
+    }
+    if (latencyReportPath != NULL)
+      WriteLatencyReport();
+    InputThreadStop();
+    ReplayWriterClose(&replayWriter);
+    ReplayReaderClose(&replayReader);
+    ReplayReaderClose(&attractReader);
+    if (timelineFile != NULL)
+      fclose(timelineFile);
+
+    LeaderboardClose();
     UnloadFont(font);
-    UnloadFont(fontSm);
-    UnloadFont(fontLg);
+    UnloadShader(fontShader);
+    UnloadRenderTexture(menuLayer);
+    UnloadCircleRenderer();
     CloseWindow();        
     return 0;
 }
@@ -0,0 +1,595 @@
+#include "replay.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+enum {
+  REPLAY_RECORD_FRAME,
+  REPLAY_RECORD_FRAME_INPUT,
+  REPLAY_RECORD_KEYFRAME,
+  REPLAY_RECORD_INDEX
+};
+
+#define REPLAY_MAGIC "CSRP"
+#define REPLAY_INDEX_MAGIC "CSIX"
+#define REPLAY_FOOTER_SIZE 12
+
+// Forces the next frame to spell out its input, so playback can start at any keyframe
+#define REPLAY_INPUT_UNKNOWN 0xffffffffu
+
+//Encoding
+static void WriteVarint(FILE* file, uint64_t value)
+{
+  while (value >= 0x80)
+  {
+    fputc((int)(value & 0x7f) | 0x80, file);
+    value >>= 7;
+  }
+  fputc((int)value, file);
+}
+
+static bool ReadVarint(FILE* file, uint64_t* value)
+{
+  *value = 0;
+  for (int shift = 0; shift < 64; shift += 7)
+  {
+    int c = fgetc(file);
+    if (c == EOF)
+      return false;
+
+    *value |= (uint64_t)(c & 0x7f) << shift;
+    if (!(c & 0x80))
+      return true;
+  }
+  return false;
+}
+
+static void WriteU64(FILE* file, uint64_t value)
+{
+  for (int i = 0; i < 8; i++)
+  {
+    fputc((int)((value >> (i * 8)) & 0xff), file);
+  }
+}
+
+static bool ReadU64(FILE* file, uint64_t* value)
+{
+  *value = 0;
+  for (int i = 0; i < 8; i++)
+  {
+    int c = fgetc(file);
+    if (c == EOF)
+      return false;
+    *value |= (uint64_t)c << (i * 8);
+  }
+  return true;
+}
+
+// Frame times are stored as the change from the last one, which is usually tiny
+static uint64_t ZigZag(int64_t value)
+{
+  return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+}
+
+static int64_t UnZigZag(uint64_t value)
+{
+  return (int64_t)(value >> 1) ^ -(int64_t)(value & 1);
+}
+
+static void WriteInt(FILE* file, int value)
+{
+  WriteVarint(file, ZigZag(value));
+}
+
+static bool ReadInt(FILE* file, int* value)
+{
+  uint64_t raw;
+  if (!ReadVarint(file, &raw))
+    return false;
+  *value = (int)UnZigZag(raw);
+  return true;
+}
+
+static bool ReadUint(FILE* file, unsigned int* value)
+{
+  uint64_t raw;
+  if (!ReadVarint(file, &raw))
+    return false;
+  *value = (unsigned int)raw;
+  return true;
+}
+
+static bool ReadBool(FILE* file, bool* value)
+{
+  uint64_t raw;
+  if (!ReadVarint(file, &raw))
+    return false;
+  *value = raw != 0;
+  return true;
+}
+
+// Floats go as their IEEE bits
+static void WriteFloat(FILE* file, float value)
+{
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  WriteVarint(file, bits);
+}
+
+static bool ReadFloat(FILE* file, float* value)
+{
+  uint64_t raw;
+  if (!ReadVarint(file, &raw))
+    return false;
+  uint32_t bits = (uint32_t)raw;
+  memcpy(value, &bits, sizeof(bits));
+  return true;
+}
+
+// Keyframes spell out every field in this order, so a replay doesn't depend on the struct's
+// layout, padding or byte order. A new field in CsimonGame goes on both lists with a version bump
+static void WriteGameState(FILE* file, const CsimonGame* game)
+{
+  WriteFloat(file, game->difficulty.initialDisplayRate);
+  WriteFloat(file, game->difficulty.displayRateAcceleration);
+  WriteFloat(file, game->difficulty.displayRateAccelerationDecceleration);
+  WriteFloat(file, game->difficulty.minDisplayRate);
+
+  WriteVarint(file, game->seed);
+  for (int i = 0; i < 4; i++)
+  {
+    WriteVarint(file, game->rng.s[i]);
+  }
+
+  WriteInt(file, game->score);
+  WriteInt(file, game->highScore);
+
+  WriteVarint(file, game->sequenceSeed);
+  WriteInt(file, game->sequenceLength);
+  WriteInt(file, game->startLength);
+  WriteVarint(file, game->marathon);
+  WriteInt(file, game->sequenceDisplayIndex);
+
+  WriteFloat(file, game->sequenceDisplayRateAcceleration);
+  WriteFloat(file, game->sequenceDisplayRate);
+  WriteVarint(file, game->sequenceTime);
+
+  WriteVarint(file, game->runTime);
+  WriteVarint(file, game->menuTime);
+
+  WriteInt(file, game->playerSequenceIndex);
+
+  WriteVarint(file, game->inputWaitTime);
+  WriteVarint(file, game->lastReactionTime);
+  WriteVarint(file, game->pressCount);
+
+  for (int i = 0; i < BUTTON_AMOUNT; i++)
+  {
+    WriteVarint(file, game->buttonsLit[i]);
+  }
+
+  WriteVarint(file, game->isShowingSequence);
+  WriteVarint(file, game->isShowingButtonAnimation);
+
+  WriteInt(file, game->animationType);
+
+  WriteInt(file, game->gameoverAnimationBlinkCount);
+  WriteInt(file, game->gameoverBlinkAnimationState);
+
+  WriteInt(file, game->gameState);
+  WriteInt(file, game->gameStateAfterWait);
+  WriteVarint(file, game->gameStateWaitDuration);
+  WriteVarint(file, game->gameStateWaitTime);
+
+  WriteVarint(file, game->runsFinished);
+  WriteInt(file, game->lastScore);
+  WriteInt(file, game->lastLength);
+}
+
+static bool ReadGameState(FILE* file, CsimonGame* game)
+{
+  memset(game, 0, sizeof(*game));
+
+  bool ok = ReadFloat(file, &game->difficulty.initialDisplayRate) &&
+    ReadFloat(file, &game->difficulty.displayRateAcceleration) &&
+    ReadFloat(file, &game->difficulty.displayRateAccelerationDecceleration) &&
+    ReadFloat(file, &game->difficulty.minDisplayRate) &&
+    ReadVarint(file, &game->seed);
+
+  for (int i = 0; i < 4 && ok; i++)
+  {
+    uint64_t raw;
+    ok = ReadVarint(file, &raw);
+    game->rng.s[i] = (uint32_t)raw;
+  }
+
+  ok = ok && ReadInt(file, &game->score) &&
+    ReadInt(file, &game->highScore) &&
+    ReadVarint(file, &game->sequenceSeed) &&
+    ReadInt(file, &game->sequenceLength) &&
+    ReadInt(file, &game->startLength) &&
+    ReadBool(file, &game->marathon) &&
+    ReadInt(file, &game->sequenceDisplayIndex) &&
+    ReadFloat(file, &game->sequenceDisplayRateAcceleration) &&
+    ReadFloat(file, &game->sequenceDisplayRate) &&
+    ReadVarint(file, &game->sequenceTime) &&
+    ReadVarint(file, &game->runTime) &&
+    ReadVarint(file, &game->menuTime) &&
+    ReadInt(file, &game->playerSequenceIndex) &&
+    ReadVarint(file, &game->inputWaitTime) &&
+    ReadVarint(file, &game->lastReactionTime) &&
+    ReadUint(file, &game->pressCount);
+
+  for (int i = 0; i < BUTTON_AMOUNT && ok; i++)
+  {
+    ok = ReadBool(file, &game->buttonsLit[i]);
+  }
+
+  return ok && ReadBool(file, &game->isShowingSequence) &&
+    ReadBool(file, &game->isShowingButtonAnimation) &&
+    ReadInt(file, &game->animationType) &&
+    ReadInt(file, &game->gameoverAnimationBlinkCount) &&
+    ReadInt(file, &game->gameoverBlinkAnimationState) &&
+    ReadInt(file, &game->gameState) &&
+    ReadInt(file, &game->gameStateAfterWait) &&
+    ReadVarint(file, &game->gameStateWaitDuration) &&
+    ReadVarint(file, &game->gameStateWaitTime) &&
+    ReadUint(file, &game->runsFinished) &&
+    ReadInt(file, &game->lastScore) &&
+    ReadInt(file, &game->lastLength);
+}
+
+static uint32_t PackInput(const CsimonInput* input)
+{
+  uint32_t packed = 0;
+  for (int i = 0; i < BUTTON_AMOUNT; i++)
+  {
+    packed |= (uint32_t)input->buttonsDown[i] << i;
+  }
+  packed |= (uint32_t)(input->buttonPressed + 1) << 4;
+  packed |= (uint32_t)input->startDown << 7;
+  packed |= (uint32_t)input->toggleSequence << 8;
+  return packed;
+}
+
+static CsimonInput UnpackInput(uint32_t packed)
+{
+  CsimonInput input;
+  for (int i = 0; i < BUTTON_AMOUNT; i++)
+  {
+    input.buttonsDown[i] = (packed >> i) & 1;
+  }
+  input.buttonPressed = (int)((packed >> 4) & 7) - 1;
+  input.startDown = (packed >> 7) & 1;
+  input.toggleSequence = (packed >> 8) & 1;
+  return input;
+}
+
+static uint32_t DtToUs(float dt)
+{
+  if (dt < 0.f) dt = 0.f;
+  return (uint32_t)(dt * 1000000.f + 0.5f);
+}
+
+static float UsToDt(uint32_t us)
+{
+  return (float)us / 1000000.f;
+}
+
+float ReplayQuantizeDt(float dt)
+{
+  return UsToDt(DtToUs(dt));
+}
+
+static bool IndexAdd(ReplayIndex* index, ReplayKeyframe keyframe)
+{
+  if (index->count == index->capacity)
+  {
+    size_t capacity = index->capacity ? index->capacity * 2 : 64;
+    ReplayKeyframe* keyframes = realloc(index->keyframes, capacity * sizeof(ReplayKeyframe));
+    if (keyframes == NULL)
+      return false;
+    index->keyframes = keyframes;
+    index->capacity = capacity;
+  }
+  index->keyframes[index->count++] = keyframe;
+  return true;
+}
+
+//Writing
+bool ReplayWriterOpen(ReplayWriter* writer, const char* path, const CsimonGame* game)
+{
+  memset(writer, 0, sizeof(*writer));
+
+  writer->file = fopen(path, "wb");
+  if (writer->file == NULL)
+  {
+    perror("Error opening replay for writing");
+    return false;
+  }
+
+  fwrite(REPLAY_MAGIC, 1, 4, writer->file);
+  fputc(REPLAY_VERSION, writer->file);
+  WriteU64(writer->file, game->seed);
+
+  writer->lastInput = REPLAY_INPUT_UNKNOWN;
+  writer->lastLength = -1;
+  return true;
+}
+
+static void WriteKeyframe(ReplayWriter* writer, const CsimonGame* game)
+{
+  ReplayKeyframe keyframe = { writer->round, writer->frame, (uint64_t)ftell(writer->file) };
+  IndexAdd(&writer->index, keyframe);
+
+  WriteVarint(writer->file, REPLAY_RECORD_KEYFRAME);
+  WriteVarint(writer->file, keyframe.round);
+  WriteVarint(writer->file, keyframe.frame);
+  WriteGameState(writer->file, game);
+
+  writer->lastKeyframe = writer->frame;
+  writer->lastInput = REPLAY_INPUT_UNKNOWN;
+  writer->lastDtUs = 0;
+
+  // Anything up to here survives a crash
+  fflush(writer->file);
+}
+
+void ReplayWriterFrame(ReplayWriter* writer, const CsimonGame* game, const CsimonInput* input, float dt)
+{
+  if (writer->file == NULL)
+    return;
+
+  bool newRound = game->sequenceLength != writer->lastLength || game->runsFinished != writer->lastRunsFinished;
+  if (newRound)
+  {
+    if (writer->lastLength != -1) writer->round++;
+    writer->lastLength = game->sequenceLength;
+    writer->lastRunsFinished = game->runsFinished;
+  }
+  if (newRound || writer->frame - writer->lastKeyframe >= REPLAY_KEYFRAME_INTERVAL)
+  {
+    WriteKeyframe(writer, game);
+  }
+
+  uint32_t packed = PackInput(input);
+  uint32_t dtUs = DtToUs(dt);
+
+  uint64_t dtField = ZigZag((int64_t)dtUs - (int64_t)writer->lastDtUs);
+  if (packed != writer->lastInput)
+  {
+    WriteVarint(writer->file, (dtField << 2) | REPLAY_RECORD_FRAME_INPUT);
+    WriteVarint(writer->file, packed);
+  } else
+  {
+    WriteVarint(writer->file, (dtField << 2) | REPLAY_RECORD_FRAME);
+  }
+
+  writer->lastInput = packed;
+  writer->lastDtUs = dtUs;
+  writer->frame++;
+}
+
+void ReplayWriterClose(ReplayWriter* writer)
+{
+  if (writer->file == NULL)
+    return;
+
+  uint64_t indexOffset = (uint64_t)ftell(writer->file);
+  WriteVarint(writer->file, REPLAY_RECORD_INDEX);
+  WriteVarint(writer->file, writer->index.count);
+  for (size_t i = 0; i < writer->index.count; i++)
+  {
+    WriteVarint(writer->file, writer->index.keyframes[i].round);
+    WriteVarint(writer->file, writer->index.keyframes[i].frame);
+    WriteVarint(writer->file, writer->index.keyframes[i].offset);
+  }
+  WriteU64(writer->file, indexOffset);
+  fwrite(REPLAY_INDEX_MAGIC, 1, 4, writer->file);
+
+  if (fclose(writer->file) != 0)
+  {
+    perror("Could not finish writing replay");
+  }
+  free(writer->index.keyframes);
+  memset(writer, 0, sizeof(*writer));
+}
+
+//Reading
+static bool ReadFooterIndex(ReplayReader* reader)
+{
+  if (fseek(reader->file, -REPLAY_FOOTER_SIZE, SEEK_END) != 0)
+    return false;
+
+  uint64_t indexOffset;
+  char magic[4];
+  if (!ReadU64(reader->file, &indexOffset) || fread(magic, 1, 4, reader->file) != 4 ||
+      memcmp(magic, REPLAY_INDEX_MAGIC, 4) != 0)
+    return false;
+
+  uint64_t tag, count;
+  if (fseek(reader->file, (long)indexOffset, SEEK_SET) != 0 ||
+      !ReadVarint(reader->file, &tag) || tag != REPLAY_RECORD_INDEX ||
+      !ReadVarint(reader->file, &count))
+    return false;
+
+  for (uint64_t i = 0; i < count; i++)
+  {
+    ReplayKeyframe keyframe;
+    if (!ReadVarint(reader->file, &keyframe.round) ||
+        !ReadVarint(reader->file, &keyframe.frame) ||
+        !ReadVarint(reader->file, &keyframe.offset) ||
+        !IndexAdd(&reader->index, keyframe))
+      return false;
+  }
+  return true;
+}
+
+// For replays that never got closed properly
+static void ScanIndex(ReplayReader* reader)
+{
+  reader->index.count = 0;
+  fseek(reader->file, reader->dataStart, SEEK_SET);
+
+  while (true)
+  {
+    long offset = ftell(reader->file);
+    uint64_t value, skip;
+    if (!ReadVarint(reader->file, &value))
+      return;
+
+    switch (value & 3)
+    {
+      case REPLAY_RECORD_FRAME:
+        break;
+      case REPLAY_RECORD_FRAME_INPUT:
+        if (!ReadVarint(reader->file, &skip))
+          return;
+        break;
+      case REPLAY_RECORD_KEYFRAME:
+      {
+        // A keyframe cut off halfway through is no good
+        ReplayKeyframe keyframe = { 0, 0, (uint64_t)offset };
+        CsimonGame state;
+        if (!ReadVarint(reader->file, &keyframe.round) ||
+            !ReadVarint(reader->file, &keyframe.frame) ||
+            !ReadGameState(reader->file, &state))
+          return;
+        IndexAdd(&reader->index, keyframe);
+        break;
+      }
+      case REPLAY_RECORD_INDEX:
+        return;
+    }
+  }
+}
+
+static bool LoadKeyframe(ReplayReader* reader, const ReplayKeyframe* keyframe, CsimonGame* game)
+{
+  uint64_t tag, round, frame;
+  if (fseek(reader->file, (long)keyframe->offset, SEEK_SET) != 0 ||
+      !ReadVarint(reader->file, &tag) || tag != REPLAY_RECORD_KEYFRAME ||
+      !ReadVarint(reader->file, &round) || !ReadVarint(reader->file, &frame) ||
+      !ReadGameState(reader->file, game))
+    return false;
+
+  reader->round = round;
+  reader->frame = frame;
+  reader->input = REPLAY_INPUT_UNKNOWN;
+  reader->dtUs = 0;
+  return true;
+}
+
+bool ReplayReaderOpen(ReplayReader* reader, const char* path, CsimonGame* game)
+{
+  memset(reader, 0, sizeof(*reader));
+
+  reader->file = fopen(path, "rb");
+  if (reader->file == NULL)
+  {
+    perror("Error opening replay");
+    return false;
+  }
+
+  char magic[4];
+  if (fread(magic, 1, 4, reader->file) != 4 || memcmp(magic, REPLAY_MAGIC, 4) != 0 ||
+      fgetc(reader->file) != REPLAY_VERSION ||
+      !ReadU64(reader->file, &reader->seed))
+  {
+    fprintf(stderr, "%s is not a replay this version can read\n", path);
+    ReplayReaderClose(reader);
+    return false;
+  }
+  reader->dataStart = ftell(reader->file);
+
+  if (!ReadFooterIndex(reader))
+  {
+    printf("Replay %s has no index, scanning it\n", path);
+    ScanIndex(reader);
+  }
+
+  if (reader->index.count == 0 || !LoadKeyframe(reader, &reader->index.keyframes[0], game))
+  {
+    fprintf(stderr, "%s has no playable frames\n", path);
+    ReplayReaderClose(reader);
+    return false;
+  }
+  return true;
+}
+
+bool ReplayReaderNext(ReplayReader* reader, CsimonInput* input, float* dt)
+{
+  if (reader->file == NULL)
+    return false;
+
+  while (true)
+  {
+    uint64_t value, packed, skip;
+    if (!ReadVarint(reader->file, &value))
+      return false;
+
+    switch (value & 3)
+    {
+      case REPLAY_RECORD_FRAME_INPUT:
+        if (!ReadVarint(reader->file, &packed))
+          return false;
+        reader->input = (uint32_t)packed;
+        // fallthrough
+      case REPLAY_RECORD_FRAME:
+        reader->dtUs = (uint32_t)((int64_t)reader->dtUs + UnZigZag(value >> 2));
+        if (reader->input == REPLAY_INPUT_UNKNOWN)
+          return false;
+
+        *input = UnpackInput(reader->input);
+        *dt = UsToDt(reader->dtUs);
+        reader->frame++;
+        return true;
+
+      case REPLAY_RECORD_KEYFRAME:
+      {
+        // Playing straight through, the state is already right
+        CsimonGame state;
+        if (!ReadVarint(reader->file, &reader->round) || !ReadVarint(reader->file, &skip) ||
+            !ReadGameState(reader->file, &state))
+          return false;
+        reader->dtUs = 0;
+        break;
+      }
+
+      case REPLAY_RECORD_INDEX:
+        return false;
+    }
+  }
+}
+
+bool ReplayReaderSeekRound(ReplayReader* reader, uint64_t round, CsimonGame* game)
+{
+  if (reader->file == NULL || reader->index.count == 0)
+    return false;
+
+  // First keyframe of the round, or the last one before it if the file ends early
+  size_t low = 0;
+  size_t high = reader->index.count;
+  while (low < high)
+  {
+    size_t mid = low + (high - low) / 2;
+    if (reader->index.keyframes[mid].round < round)
+      low = mid + 1;
+    else
+      high = mid;
+  }
+  if (low == reader->index.count)
+    low--;
+
+  return LoadKeyframe(reader, &reader->index.keyframes[low], game);
+}
+
+void ReplayReaderClose(ReplayReader* reader)
+{
+  if (reader->file != NULL)
+  {
+    fclose(reader->file);
+  }
+  free(reader->index.keyframes);
+  memset(reader, 0, sizeof(*reader));
+}
@@ -0,0 +1,83 @@
+#ifndef CSIMON_REPLAY_H
+#define CSIMON_REPLAY_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "game.h"
+
+// Replays are the input and frame time of every tick, varint packed, with a full
+// copy of the game state (keyframe) at the start of every round and every
+// REPLAY_KEYFRAME_INTERVAL ticks. An index of the keyframes goes at the end so
+// seeking to a round is a binary search. Files cut off by a crash are still
+// readable, the index gets rebuilt by scanning.
+//
+// File layout:
+//   "CSRP" version:u8 seed:u64
+//   records, each starting with a varint whose low 2 bits say what it is:
+//     REPLAY_RECORD_FRAME        upper bits: zigzag change in frame time (us), reset to 0 at keyframes
+//     REPLAY_RECORD_FRAME_INPUT  same, followed by the new packed input as a varint
+//     REPLAY_RECORD_KEYFRAME     round:varint frame:varint state, every CsimonGame field in
+//                                declaration order as a varint (signed ones zigzagged, floats
+//                                as their IEEE bits), see WriteGameState
+//     REPLAY_RECORD_INDEX        count:varint (round, frame, offset):varint each
+//   indexOffset:u64 "CSIX"
+
+#define REPLAY_VERSION 2
+#define REPLAY_KEYFRAME_INTERVAL 600
+
+typedef struct ReplayKeyframe {
+  uint64_t round;
+  uint64_t frame;
+  uint64_t offset;
+} ReplayKeyframe;
+
+typedef struct ReplayIndex {
+  ReplayKeyframe* keyframes;
+  size_t count;
+  size_t capacity;
+} ReplayIndex;
+
+typedef struct ReplayWriter {
+  FILE* file;
+  ReplayIndex index;
+  uint32_t lastInput;
+  uint32_t lastDtUs;
+  uint64_t frame;
+  uint64_t round;
+  uint64_t lastKeyframe;
+  int lastLength;
+  unsigned int lastRunsFinished;
+} ReplayWriter;
+
+typedef struct ReplayReader {
+  FILE* file;
+  ReplayIndex index;
+  uint64_t seed;
+  uint64_t frame;
+  uint64_t round;
+  uint32_t input;
+  uint32_t dtUs;
+  long dataStart;
+} ReplayReader;
+
+// Frame times are stored in whole microseconds, so the live game has to step with
+// the same rounded value for replays to come out identical
+float ReplayQuantizeDt(float dt);
+
+bool ReplayWriterOpen(ReplayWriter* writer, const char* path, const CsimonGame* game);
+// Call with the state from before the tick gets stepped
+void ReplayWriterFrame(ReplayWriter* writer, const CsimonGame* game, const CsimonInput* input, float dt);
+// Writes the index and closes the file
+void ReplayWriterClose(ReplayWriter* writer);
+
+// Loads the first keyframe into game
+bool ReplayReaderOpen(ReplayReader* reader, const char* path, CsimonGame* game);
+// Next tick to step, false once the replay runs out
+bool ReplayReaderNext(ReplayReader* reader, CsimonInput* input, float* dt);
+// Jumps to the start of a round (counted from 0 over the whole file), game gets that round's state
+bool ReplayReaderSeekRound(ReplayReader* reader, uint64_t round, CsimonGame* game);
+void ReplayReaderClose(ReplayReader* reader);
+
+#endif
@@ -0,0 +1,74 @@
+#include "rng.h"
+
+static uint64_t SplitMix64(uint64_t* x)
+{
+  uint64_t z = (*x += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+uint64_t CsimonRngHash(uint64_t key, uint64_t counter)
+{
+  uint64_t x = key ^ (counter * 0xd1b54a32d192ed03ULL);
+  SplitMix64(&x);
+  return SplitMix64(&x);
+}
+
+static uint32_t Rotl(uint32_t x, int k)
+{
+  return (x << k) | (x >> (32 - k));
+}
+
+void CsimonRngSeed(CsimonRng* rng, uint64_t seed)
+{
+  // Spread the seed out so small seeds (0, 1, 2...) still give a good state, never all zero
+  uint64_t a = SplitMix64(&seed);
+  uint64_t b = SplitMix64(&seed);
+  rng->s[0] = (uint32_t)a;
+  rng->s[1] = (uint32_t)(a >> 32);
+  rng->s[2] = (uint32_t)b;
+  rng->s[3] = (uint32_t)(b >> 32);
+}
+
+uint32_t CsimonRngNext(CsimonRng* rng)
+{
+  uint32_t* s = rng->s;
+  uint32_t result = Rotl(s[1] * 5, 7) * 9;
+  uint32_t t = s[1] << 9;
+
+  s[2] ^= s[0];
+  s[3] ^= s[1];
+  s[1] ^= s[2];
+  s[0] ^= s[3];
+
+  s[2] ^= t;
+  s[3] = Rotl(s[3], 11);
+
+  return result;
+}
+
+float CsimonRngFloat(CsimonRng* rng)
+{
+  return (float)(CsimonRngNext(rng) >> 8) / (float)(1 << 24);
+}
+
+int CsimonRngButton(CsimonRng* rng)
+{
+  return (int)(CsimonRngNext(rng) >> 30);
+}
+
+uint32_t CsimonRngRange(CsimonRng* rng, uint32_t range)
+{
+  // Multiply and keep the top 32 bits, the few low products that would favour some values get redrawn
+  uint64_t product = (uint64_t)CsimonRngNext(rng) * range;
+  if ((uint32_t)product < range)
+  {
+    uint32_t threshold = (0u - range) % range;
+    while ((uint32_t)product < threshold)
+    {
+      product = (uint64_t)CsimonRngNext(rng) * range;
+    }
+  }
+  return (uint32_t)(product >> 32);
+}
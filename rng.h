@@ -0,0 +1,24 @@
+#ifndef CSIMON_RNG_H
+#define CSIMON_RNG_H
+
+#include <stdint.h>
+
+// xoshiro128**, small and fast, same seed always gives the same numbers
+typedef struct CsimonRng {
+  uint32_t s[4];
+} CsimonRng;
+
+void CsimonRngSeed(CsimonRng* rng, uint64_t seed);
+uint32_t CsimonRngNext(CsimonRng* rng);
+// Uniform in [0, 1)
+float CsimonRngFloat(CsimonRng* rng);
+// Uniform 0-3, taken from the top two bits so there's no modulo bias
+int CsimonRngButton(CsimonRng* rng);
+// Uniform in [0, range), redraws instead of taking a modulo so no value comes up more often
+uint32_t CsimonRngRange(CsimonRng* rng, uint32_t range);
+
+// Stateless 64 random bits for (key, counter), the same pair always gives the same bits.
+// Lets a sequence be looked up at any index without storing it
+uint64_t CsimonRngHash(uint64_t key, uint64_t counter);
+
+#endif
@@ -0,0 +1,296 @@
+#include "save.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#ifdef _WIN32
+  #include <windows.h>
+  #include <io.h>
+#else
+  #include <unistd.h>
+  #include <fcntl.h>
+#endif
+
+// No threads in the web build, saves there just happen straight away
+#ifndef __EMSCRIPTEN__
+  #include <pthread.h>
+  #define SAVE_THREADED
+#endif
+
+#define SAVE_MAGIC "CSSV"
+#define SAVE_HEADER_SIZE 12
+#define LEGACY_SAVE_SIZE (7 * 4)
+
+uint32_t SaveCrc32(const void* buffer, size_t size)
+{
+  const unsigned char* data = buffer;
+  uint32_t crc = 0xffffffffu;
+  for (size_t i = 0; i < size; i++)
+  {
+    crc ^= data[i];
+    for (int bit = 0; bit < 8; bit++)
+    {
+      crc = (crc >> 1) ^ (0xedb88320u & (0u - (crc & 1u)));
+    }
+  }
+  return ~crc;
+}
+
+static void PutU32(unsigned char* out, uint32_t value)
+{
+  for (int i = 0; i < 4; i++)
+  {
+    out[i] = (unsigned char)((value >> (i * 8)) & 0xff);
+  }
+}
+
+static uint32_t GetU32(const unsigned char* in)
+{
+  uint32_t value = 0;
+  for (int i = 0; i < 4; i++)
+  {
+    value |= (uint32_t)in[i] << (i * 8);
+  }
+  return value;
+}
+
+// The original format, seven ints of padding around highScore << 4
+static bool ReadLegacy(const unsigned char* buffer, size_t size, SaveData* data)
+{
+  if (size != LEGACY_SAVE_SIZE)
+    return false;
+
+  int legacy[7];
+  memcpy(legacy, buffer, sizeof(legacy));
+  if (legacy[0] != 10 || legacy[1] != 255 || legacy[2] != 15 ||
+      legacy[4] != 15 || legacy[5] != 255 || legacy[6] != 10)
+    return false;
+
+  data->highScore = legacy[3] >> 4;
+  return true;
+}
+
+bool SaveRead(const char* path, SaveData* data)
+{
+  FILE* file = fopen(path, "rb");
+  if (file == NULL)
+  {
+    perror("Error reading savefile");
+    return false;
+  }
+
+  unsigned char buffer[SAVE_MAX_SIZE];
+  size_t size = fread(buffer, 1, sizeof(buffer), file);
+  fclose(file);
+
+  if (size < SAVE_HEADER_SIZE + 4 || memcmp(buffer, SAVE_MAGIC, 4) != 0)
+  {
+    if (ReadLegacy(buffer, size, data))
+    {
+      printf("Savefile is in the old format, it'll be upgraded on the next save\n");
+      return true;
+    }
+    printf("Savefile is corrupt\n");
+    return false;
+  }
+
+  uint32_t version = GetU32(buffer + 4);
+  uint32_t payloadSize = GetU32(buffer + 8);
+  if (payloadSize > size - SAVE_HEADER_SIZE - 4 ||
+      GetU32(buffer + SAVE_HEADER_SIZE + payloadSize) != SaveCrc32(buffer, SAVE_HEADER_SIZE + payloadSize))
+  {
+    printf("Savefile is corrupt\n");
+    return false;
+  }
+
+  if (version > SAVE_VERSION)
+    printf("Savefile is from a newer version, reading what we know of it\n");
+
+  const unsigned char* payload = buffer + SAVE_HEADER_SIZE;
+  SaveData loaded = *data;
+  if (payloadSize >= 4) loaded.highScore = (int)GetU32(payload);
+
+  *data = loaded;
+  return true;
+}
+
+static bool SyncAndClose(FILE* file)
+{
+  bool ok = fflush(file) == 0;
+#ifdef _WIN32
+  ok = ok && _commit(_fileno(file)) == 0;
+#else
+  ok = ok && fsync(fileno(file)) == 0;
+#endif
+  return (fclose(file) == 0) && ok;
+}
+
+static bool ReplaceFile(const char* from, const char* to)
+{
+#ifdef _WIN32
+  return MoveFileExA(from, to, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+  if (rename(from, to) != 0)
+    return false;
+
+  // The rename itself only sticks once the directory is synced
+  char directory[SAVE_MAX_SIZE];
+  snprintf(directory, sizeof(directory), "%s", to);
+  char* slash = strrchr(directory, '/');
+  if (slash != NULL) *slash = '\0';
+  else snprintf(directory, sizeof(directory), ".");
+
+  int fd = open(directory, O_RDONLY);
+  if (fd >= 0)
+  {
+    fsync(fd);
+    close(fd);
+  }
+  return true;
+#endif
+}
+
+bool SaveWriteFile(const char* path, const void* buffer, size_t size)
+{
+  char tempPath[SAVE_MAX_SIZE];
+  snprintf(tempPath, sizeof(tempPath), "%s.tmp", path);
+
+  FILE* file = fopen(tempPath, "wb");
+  if (file == NULL)
+  {
+    perror(tempPath);
+    return false;
+  }
+
+  bool written = fwrite(buffer, 1, size, file) == size;
+  if (!SyncAndClose(file) || !written)
+  {
+    perror(tempPath);
+    remove(tempPath);
+    return false;
+  }
+
+  if (!ReplaceFile(tempPath, path))
+  {
+    perror(path);
+    remove(tempPath);
+    return false;
+  }
+  return true;
+}
+
+bool SaveWrite(const char* path, const SaveData* data)
+{
+  unsigned char buffer[SAVE_HEADER_SIZE + 4 + 4];
+  uint32_t payloadSize = 4;
+
+  memcpy(buffer, SAVE_MAGIC, 4);
+  PutU32(buffer + 4, SAVE_VERSION);
+  PutU32(buffer + 8, payloadSize);
+  PutU32(buffer + SAVE_HEADER_SIZE, (uint32_t)data->highScore);
+  PutU32(buffer + SAVE_HEADER_SIZE + payloadSize, SaveCrc32(buffer, SAVE_HEADER_SIZE + payloadSize));
+
+  return SaveWriteFile(path, buffer, sizeof(buffer));
+}
+
+#ifdef SAVE_THREADED
+
+static pthread_t thread;
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t wake = PTHREAD_COND_INITIALIZER;
+static bool running = false;
+static bool stopping = false;
+static bool hasQueued = false;
+static SaveData queued;
+static char threadPath[SAVE_MAX_SIZE];
+
+static void* SaveThread(void* arg)
+{
+  (void)arg;
+
+  pthread_mutex_lock(&lock);
+  while (true)
+  {
+    while (!hasQueued && !stopping)
+      pthread_cond_wait(&wake, &lock);
+
+    if (!hasQueued)
+      break;
+
+    SaveData data = queued;
+    hasQueued = false;
+
+    // The game can keep queueing while the disk is busy
+    pthread_mutex_unlock(&lock);
+    SaveWrite(threadPath, &data);
+    pthread_mutex_lock(&lock);
+  }
+  pthread_mutex_unlock(&lock);
+  return NULL;
+}
+
+bool SaveThreadStart(const char* path)
+{
+  if (running)
+    return true;
+
+  snprintf(threadPath, sizeof(threadPath), "%s", path);
+  stopping = false;
+  hasQueued = false;
+
+  if (pthread_create(&thread, NULL, SaveThread, NULL) != 0)
+  {
+    printf("Could not start save thread, saving on the main thread\n");
+    return false;
+  }
+  running = true;
+  return true;
+}
+
+void SaveThreadQueue(const SaveData* data)
+{
+  if (!running)
+  {
+    SaveWrite(threadPath, data);
+    return;
+  }
+
+  pthread_mutex_lock(&lock);
+  queued = *data;
+  hasQueued = true;
+  pthread_cond_signal(&wake);
+  pthread_mutex_unlock(&lock);
+}
+
+void SaveThreadStop(void)
+{
+  if (!running)
+    return;
+
+  pthread_mutex_lock(&lock);
+  stopping = true;
+  pthread_cond_signal(&wake);
+  pthread_mutex_unlock(&lock);
+
+  pthread_join(thread, NULL);
+  running = false;
+}
+
+#else
+
+static char threadPath[SAVE_MAX_SIZE];
+
+bool SaveThreadStart(const char* path)
+{
+  snprintf(threadPath, sizeof(threadPath), "%s", path);
+  return false;
+}
+
+void SaveThreadQueue(const SaveData* data)
+{
+  SaveWrite(threadPath, data);
+}
+
+void SaveThreadStop(void) {}
+
+#endif
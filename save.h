@@ -0,0 +1,38 @@
+#ifndef CSIMON_SAVE_H
+#define CSIMON_SAVE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+// Save file, no raylib in here.
+//   "CSSV" version:u32 payloadSize:u32 payload crc32:u32 (of everything before it)
+// all little endian. Newer versions only ever add to the end of the payload.
+// Writes go to a temp file that gets fsynced and renamed over the old one, so a
+// power cut leaves either the old save or the new one, never half of each.
+// The old 7 int format still loads and gets replaced on the next write.
+
+#define SAVE_VERSION 2
+#define SAVE_MAX_SIZE 4096
+
+typedef struct SaveData {
+  int highScore;
+} SaveData;
+
+// False if there's no save or it's corrupt, data is left alone then
+bool SaveRead(const char* path, SaveData* data);
+// Blocks until it's on disk
+bool SaveWrite(const char* path, const SaveData* data);
+
+// The temp file, fsync and rename on their own, for other files that can't be left half written
+bool SaveWriteFile(const char* path, const void* buffer, size_t size);
+uint32_t SaveCrc32(const void* buffer, size_t size);
+
+// Write-behind, SaveThreadQueue just copies the data and returns. Only the newest
+// queued data gets written if several come in while a write is going
+bool SaveThreadStart(const char* path);
+void SaveThreadQueue(const SaveData* data);
+// Writes whatever is still queued first
+void SaveThreadStop(void);
+
+#endif
@@ -0,0 +1,385 @@
+#include "stats.h"
+
+#include <string.h>
+#include <time.h>
+
+#include "save.h"
+
+#ifdef _WIN32
+  #include <io.h>
+#else
+  #include <unistd.h>
+#endif
+
+#define LOG_MAGIC "CSLG"
+#define INDEX_MAGIC "CSSI"
+#define LOG_HEADER_SIZE 8
+#define RUN_FIXED_SIZE (8 + 8 + 4 + 4 + 8 + 4)
+#define RUN_MAX_SIZE (RUN_FIXED_SIZE + 4 * STATS_MAX_REACTIONS)
+#define TOTALS_FIELDS 7
+#define SUMMARY_FIELDS (1 + TOTALS_FIELDS + STATS_WEEKS * (1 + TOTALS_FIELDS))
+#define INDEX_SIZE (8 + SUMMARY_FIELDS * 8 + 4)
+#define SECONDS_PER_WEEK (7ull * 24 * 60 * 60)
+
+// Big enough for the longest run, only one of them is ever being read or written
+static unsigned char record[4 + RUN_MAX_SIZE + 4];
+
+static void PutU32(unsigned char* out, uint32_t value)
+{
+  for (int i = 0; i < 4; i++)
+  {
+    out[i] = (unsigned char)((value >> (i * 8)) & 0xff);
+  }
+}
+
+static void PutU64(unsigned char* out, uint64_t value)
+{
+  PutU32(out, (uint32_t)value);
+  PutU32(out + 4, (uint32_t)(value >> 32));
+}
+
+static uint32_t GetU32(const unsigned char* in)
+{
+  uint32_t value = 0;
+  for (int i = 0; i < 4; i++)
+  {
+    value |= (uint32_t)in[i] << (i * 8);
+  }
+  return value;
+}
+
+static uint64_t GetU64(const unsigned char* in)
+{
+  return (uint64_t)GetU32(in) | ((uint64_t)GetU32(in + 4) << 32);
+}
+
+static void AddToTotals(StatsTotals* totals, const StatsRun* run, uint64_t reactionUs)
+{
+  totals->runs++;
+  if ((uint64_t)run->score > totals->bestScore) totals->bestScore = (uint64_t)run->score;
+  if ((uint64_t)run->length > totals->bestLength) totals->bestLength = (uint64_t)run->length;
+  totals->score += (uint64_t)run->score;
+  totals->durationUs += run->durationUs;
+  totals->presses += (uint64_t)run->reactionCount;
+  totals->reactionUs += reactionUs;
+}
+
+static void AddToSummary(StatsSummary* summary, const StatsRun* run)
+{
+  uint64_t reactionUs = 0;
+  for (int i = 0; i < run->reactionCount; i++)
+  {
+    reactionUs += run->reactionUs[i];
+  }
+  AddToTotals(&summary->totals, run, reactionUs);
+
+  // A run from before the oldest kept week (clock got set back) only counts in the totals
+  uint64_t week = run->time / SECONDS_PER_WEEK;
+  StatsWeek* slot = &summary->weeks[week % STATS_WEEKS];
+  if (slot->totals.runs > 0 && slot->week > week)
+    return;
+  if (slot->week != week)
+  {
+    memset(slot, 0, sizeof(*slot));
+    slot->week = week;
+  }
+  AddToTotals(&slot->totals, run, reactionUs);
+}
+
+static unsigned char* PutTotals(unsigned char* out, const StatsTotals* totals)
+{
+  const uint64_t fields[TOTALS_FIELDS] = {
+    totals->runs, totals->bestScore, totals->bestLength, totals->score,
+    totals->durationUs, totals->presses, totals->reactionUs
+  };
+  for (int i = 0; i < TOTALS_FIELDS; i++, out += 8)
+  {
+    PutU64(out, fields[i]);
+  }
+  return out;
+}
+
+static const unsigned char* GetTotals(const unsigned char* in, StatsTotals* totals)
+{
+  uint64_t* fields[TOTALS_FIELDS] = {
+    &totals->runs, &totals->bestScore, &totals->bestLength, &totals->score,
+    &totals->durationUs, &totals->presses, &totals->reactionUs
+  };
+  for (int i = 0; i < TOTALS_FIELDS; i++, in += 8)
+  {
+    *fields[i] = GetU64(in);
+  }
+  return in;
+}
+
+static bool ReadIndex(const char* path, StatsSummary* summary)
+{
+  FILE* file = fopen(path, "rb");
+  if (file == NULL)
+    return false;
+
+  unsigned char buffer[INDEX_SIZE];
+  size_t size = fread(buffer, 1, sizeof(buffer), file);
+  fclose(file);
+
+  if (size != INDEX_SIZE || memcmp(buffer, INDEX_MAGIC, 4) != 0 ||
+      GetU32(buffer + 4) != STATS_VERSION ||
+      GetU32(buffer + INDEX_SIZE - 4) != SaveCrc32(buffer, INDEX_SIZE - 4))
+  {
+    printf("Stats index at %s is unreadable, rebuilding it from the log\n", path);
+    return false;
+  }
+
+  const unsigned char* in = buffer + 8;
+  summary->logSize = GetU64(in);
+  in = GetTotals(in + 8, &summary->totals);
+  for (int i = 0; i < STATS_WEEKS; i++)
+  {
+    summary->weeks[i].week = GetU64(in);
+    in = GetTotals(in + 8, &summary->weeks[i].totals);
+  }
+  return true;
+}
+
+static bool WriteIndex(StatsStore* store)
+{
+  unsigned char buffer[INDEX_SIZE];
+  memcpy(buffer, INDEX_MAGIC, 4);
+  PutU32(buffer + 4, STATS_VERSION);
+
+  unsigned char* out = buffer + 8;
+  PutU64(out, store->summary.logSize);
+  out = PutTotals(out + 8, &store->summary.totals);
+  for (int i = 0; i < STATS_WEEKS; i++)
+  {
+    PutU64(out, store->summary.weeks[i].week);
+    out = PutTotals(out + 8, &store->summary.weeks[i].totals);
+  }
+  PutU32(buffer + INDEX_SIZE - 4, SaveCrc32(buffer, INDEX_SIZE - 4));
+
+  store->unindexedRuns = 0;
+  return SaveWriteFile(store->indexPath, buffer, sizeof(buffer));
+}
+
+// Reads the record at the current position into run, false at the end of the log or on a torn one
+static bool ReadRun(FILE* file, StatsRun* run, uint64_t* recordSize)
+{
+  if (fread(record, 1, 4, file) != 4)
+    return false;
+
+  uint32_t size = GetU32(record);
+  if (size < RUN_FIXED_SIZE || size > RUN_MAX_SIZE || fread(record + 4, 1, size + 4, file) != size + 4)
+    return false;
+  if (GetU32(record + 4 + size) != SaveCrc32(record, 4 + size))
+    return false;
+
+  const unsigned char* in = record + 4;
+  run->seed = GetU64(in);
+  run->time = GetU64(in + 8);
+  run->score = (int)GetU32(in + 16);
+  run->length = (int)GetU32(in + 20);
+  run->durationUs = GetU64(in + 24);
+  run->reactionCount = (int)GetU32(in + 32);
+  if (run->reactionCount < 0 || RUN_FIXED_SIZE + 4 * (uint64_t)run->reactionCount != size)
+    return false;
+
+  for (int i = 0; i < run->reactionCount; i++)
+  {
+    run->reactionUs[i] = GetU32(in + RUN_FIXED_SIZE + i * 4);
+  }
+
+  *recordSize = 4 + size + 4;
+  return true;
+}
+
+static bool TruncateLog(FILE* file, uint64_t size)
+{
+  fflush(file);
+#ifdef _WIN32
+  return _chsize_s(_fileno(file), (long long)size) == 0;
+#else
+  return ftruncate(fileno(file), (off_t)size) == 0;
+#endif
+}
+
+bool StatsOpen(StatsStore* store, const char* base)
+{
+  memset(store, 0, sizeof(*store));
+  snprintf(store->logPath, sizeof(store->logPath), "%s.log", base);
+  snprintf(store->indexPath, sizeof(store->indexPath), "%s.idx", base);
+
+  // Appends always land at the end whatever the read position is
+  FILE* file = fopen(store->logPath, "ab+");
+  if (file == NULL)
+  {
+    perror("Error opening stats log");
+    return false;
+  }
+
+  fseek(file, 0, SEEK_END);
+  long logSize = ftell(file);
+  if (logSize == 0)
+  {
+    unsigned char header[LOG_HEADER_SIZE];
+    memcpy(header, LOG_MAGIC, 4);
+    PutU32(header + 4, STATS_VERSION);
+    fwrite(header, 1, sizeof(header), file);
+    fflush(file);
+    logSize = LOG_HEADER_SIZE;
+  } else
+  {
+    unsigned char header[LOG_HEADER_SIZE];
+    fseek(file, 0, SEEK_SET);
+    if (fread(header, 1, sizeof(header), file) != sizeof(header) || memcmp(header, LOG_MAGIC, 4) != 0)
+    {
+      printf("%s isn't a stats log, leaving it alone\n", store->logPath);
+      fclose(file);
+      return false;
+    }
+  }
+
+  // An index ahead of the log means the log got swapped out from under it
+  if (!ReadIndex(store->indexPath, &store->summary) ||
+      store->summary.logSize < LOG_HEADER_SIZE || store->summary.logSize > (uint64_t)logSize)
+  {
+    memset(&store->summary, 0, sizeof(store->summary));
+    store->summary.logSize = LOG_HEADER_SIZE;
+  }
+
+  static StatsRun run;
+  uint64_t recordSize;
+  fseek(file, (long)store->summary.logSize, SEEK_SET);
+  while (ReadRun(file, &run, &recordSize))
+  {
+    AddToSummary(&store->summary, &run);
+    store->summary.logSize += recordSize;
+    store->unindexedRuns++;
+  }
+
+  if (store->summary.logSize < (uint64_t)logSize)
+  {
+    printf("Stats log ends in a partly written run, dropping it\n");
+    if (!TruncateLog(file, store->summary.logSize))
+    {
+      perror("Could not truncate stats log");
+      fclose(file);
+      return false;
+    }
+  }
+
+  // Reads and writes on the same FILE need a seek in between
+  fseek(file, 0, SEEK_END);
+  store->log = file;
+  if (store->unindexedRuns > 0)
+    WriteIndex(store);
+  return true;
+}
+
+bool StatsAppend(StatsStore* store, const StatsRun* run)
+{
+  if (store->log == NULL)
+    return false;
+
+  int reactionCount = run->reactionCount;
+  if (reactionCount < 0) reactionCount = 0;
+  if (reactionCount > STATS_MAX_REACTIONS) reactionCount = STATS_MAX_REACTIONS;
+
+  uint32_t size = RUN_FIXED_SIZE + 4 * (uint32_t)reactionCount;
+  PutU32(record, size);
+  unsigned char* out = record + 4;
+  PutU64(out, run->seed);
+  PutU64(out + 8, run->time);
+  PutU32(out + 16, (uint32_t)run->score);
+  PutU32(out + 20, (uint32_t)run->length);
+  PutU64(out + 24, run->durationUs);
+  PutU32(out + 32, (uint32_t)reactionCount);
+  for (int i = 0; i < reactionCount; i++)
+  {
+    PutU32(out + RUN_FIXED_SIZE + i * 4, run->reactionUs[i]);
+  }
+  PutU32(record + 4 + size, SaveCrc32(record, 4 + size));
+
+  size_t recordSize = 4 + size + 4;
+  if (fwrite(record, 1, recordSize, store->log) != recordSize || fflush(store->log) != 0)
+  {
+    perror("Error appending to stats log");
+    // Whatever made it out gets chopped off on the next open
+    return false;
+  }
+
+  // The summary only counts the reactions that went into the log, so a rebuild matches it
+  StatsRun counted = *run;
+  counted.reactionCount = reactionCount;
+  AddToSummary(&store->summary, &counted);
+  store->summary.logSize += recordSize;
+
+  if (++store->unindexedRuns >= STATS_INDEX_INTERVAL)
+    WriteIndex(store);
+  return true;
+}
+
+void StatsClose(StatsStore* store)
+{
+  if (store->log == NULL)
+    return;
+
+  if (store->unindexedRuns > 0)
+    WriteIndex(store);
+  fclose(store->log);
+  store->log = NULL;
+}
+
+static void WriteTotals(FILE* file, const char* name, const StatsTotals* totals)
+{
+  double runs = totals->runs ? (double)totals->runs : 1.0;
+  double presses = totals->presses ? (double)totals->presses : 1.0;
+  fprintf(file, "%-12s runs %6llu  best %5llu  best length %4llu  mean score %7.1f  played %7.1f h  mean reaction %6.0f ms\n",
+      name, (unsigned long long)totals->runs,
+      (unsigned long long)totals->bestScore, (unsigned long long)totals->bestLength,
+      (double)totals->score / runs,
+      (double)totals->durationUs / 3.6e9,
+      (double)totals->reactionUs / presses / 1e3);
+}
+
+bool StatsWriteReport(const char* path, const char* player, const StatsSummary* summary)
+{
+  FILE* file = fopen(path, "w");
+  if (file == NULL)
+  {
+    perror("Error writing stats report");
+    return false;
+  }
+
+  fprintf(file, "csimon stats for %s\n\n", player);
+  WriteTotals(file, "all time", &summary->totals);
+
+  // Newest week first
+  const StatsWeek* sorted[STATS_WEEKS];
+  int count = 0;
+  for (int i = 0; i < STATS_WEEKS; i++)
+  {
+    const StatsWeek* week = &summary->weeks[i];
+    if (week->totals.runs == 0)
+      continue;
+
+    int at = count++;
+    while (at > 0 && sorted[at - 1]->week < week->week)
+    {
+      sorted[at] = sorted[at - 1];
+      at--;
+    }
+    sorted[at] = week;
+  }
+
+  for (int i = 0; i < count; i++)
+  {
+    time_t start = (time_t)(sorted[i]->week * SECONDS_PER_WEEK);
+    char name[32];
+    strftime(name, sizeof(name), "%Y-%m-%d", gmtime(&start));
+    WriteTotals(file, name, &sorted[i]->totals);
+  }
+
+  fclose(file);
+  printf("Wrote stats report to %s\n", path);
+  return true;
+}
@@ -0,0 +1,77 @@
+#ifndef CSIMON_STATS_H
+#define CSIMON_STATS_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// Per player stats, no raylib in here. Every finished run gets appended to <base>.log,
+//   "CSLG" version:u32
+//   then per run: size:u32 seed:u64 time:u64 score:u32 length:u32 durationUs:u64
+//                 reactionCount:u32 reactionUs:u32 each, crc32:u32 (of the size bytes before it)
+// and the totals go in <base>.idx, written like the save (temp file and rename),
+//   "CSSI" version:u32 summary crc32:u32
+// along with how much of the log they cover. Opening reads the index and only scans the
+// runs appended after it, so boot doesn't get slower as the history grows. The index is
+// only rewritten every STATS_INDEX_INTERVAL runs and on close, a crash costs a slightly
+// longer scan next time. A run cut off halfway gets chopped off the end of the log.
+// All little endian, times are unix seconds.
+
+#define STATS_VERSION 1
+#define STATS_WEEKS 8
+#define STATS_MAX_REACTIONS 8192
+#define STATS_INDEX_INTERVAL 32
+#define STATS_PATH_SIZE 512
+
+typedef struct StatsRun {
+  uint64_t seed;
+  uint64_t time;
+  int score;
+  int length;
+  uint64_t durationUs;
+  int reactionCount;
+  uint32_t reactionUs[STATS_MAX_REACTIONS];
+} StatsRun;
+
+typedef struct StatsTotals {
+  uint64_t runs;
+  uint64_t bestScore;
+  uint64_t bestLength;
+  uint64_t score;
+  uint64_t durationUs;
+  uint64_t presses;
+  uint64_t reactionUs;
+} StatsTotals;
+
+// Weeks are counted from the unix epoch, the last STATS_WEEKS of them get kept
+typedef struct StatsWeek {
+  uint64_t week;
+  StatsTotals totals;
+} StatsWeek;
+
+typedef struct StatsSummary {
+  uint64_t logSize; // How much of the log is counted in here
+  StatsTotals totals;
+  StatsWeek weeks[STATS_WEEKS];
+} StatsSummary;
+
+typedef struct StatsStore {
+  FILE* log;
+  StatsSummary summary;
+  int unindexedRuns;
+  char logPath[STATS_PATH_SIZE];
+  char indexPath[STATS_PATH_SIZE];
+} StatsStore;
+
+// base is the path without the extension. False if the log can't be opened or is
+// someone else's file, the store just ignores appends then
+bool StatsOpen(StatsStore* store, const char* base);
+// One write to the end of the log, plus the index every STATS_INDEX_INTERVAL runs
+bool StatsAppend(StatsStore* store, const StatsRun* run);
+// Writes the index and closes the log
+void StatsClose(StatsStore* store);
+
+// Totals and the kept weeks as text
+bool StatsWriteReport(const char* path, const char* player, const StatsSummary* summary);
+
+#endif
@@ -0,0 +1,123 @@
+// Rasterises the embedded Roboto once at build time into a single signed distance
+// field atlas and writes it out with the glyph metrics as a header, so the game just
+// uploads one texture at boot instead of parsing the TTF. Everything here is CPU
+// side, no window needed. Only the characters the game actually draws (FONT_CHARACTERS)
+// get baked.
+//
+// Example:
+//   csimon-bake-font res/font_atlas.h
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <raylib.h>
+
+#include "font.h"
+#include "res/roboto.h"
+
+#define MAX_CODEPOINTS 256
+#define BYTES_PER_LINE 12
+
+static int CompareCodepoints(const void* a, const void* b)
+{
+  return *(const int*)a - *(const int*)b;
+}
+
+// Sorted and without duplicates
+static int SubsetCodepoints(const char* text, int* codepoints)
+{
+  int textCount = 0;
+  int* textCodepoints = LoadCodepoints(text, &textCount);
+  qsort(textCodepoints, textCount, sizeof(int), CompareCodepoints);
+
+  int count = 0;
+  for (int i = 0; i < textCount && count < MAX_CODEPOINTS; i++)
+  {
+    if (count == 0 || codepoints[count - 1] != textCodepoints[i])
+      codepoints[count++] = textCodepoints[i];
+  }
+
+  UnloadCodepoints(textCodepoints);
+  return count;
+}
+
+static void WriteBytes(FILE* file, const unsigned char* data, int size)
+{
+  for (int i = 0; i < size; i++)
+  {
+    if (i % BYTES_PER_LINE == 0) fprintf(file, "  ");
+    fprintf(file, "0x%02x%s", data[i], (i + 1 < size) ? "," : "");
+    fprintf(file, ((i + 1) % BYTES_PER_LINE == 0 || i + 1 == size) ? "\n" : " ");
+  }
+}
+
+int main(int argc, char** argv)
+{
+  if (argc < 2)
+  {
+    printf("Usage: %s OUTPUT_HEADER\n", argv[0]);
+    return 1;
+  }
+
+  SetTraceLogLevel(LOG_WARNING);
+
+  int codepoints[MAX_CODEPOINTS];
+  int codepointCount = SubsetCodepoints(FONT_CHARACTERS, codepoints);
+
+  GlyphInfo* glyphs = LoadFontData(RobotoRegular, (int)RobotoRegular_len, FONT_ATLAS_SIZE, codepoints, codepointCount, FONT_SDF);
+  if (glyphs == NULL)
+  {
+    printf("Could not rasterise the font\n");
+    return 1;
+  }
+
+  Rectangle* recs = NULL;
+  Image atlas = GenImageFontAtlas(glyphs, &recs, codepointCount, FONT_ATLAS_SIZE, FONT_ATLAS_PADDING, 1);
+
+  // The atlas is white everywhere, only the alpha (the distance) is worth keeping
+  int pixelCount = atlas.width * atlas.height;
+  unsigned char* alpha = MemAlloc(pixelCount);
+  for (int i = 0; i < pixelCount; i++)
+  {
+    alpha[i] = ((unsigned char*)atlas.data)[i*2 + 1];
+  }
+
+  int compressedSize = 0;
+  unsigned char* compressed = CompressData(alpha, pixelCount, &compressedSize);
+
+  FILE* file = fopen(argv[1], "w");
+  if (file == NULL)
+  {
+    perror("Error writing font header");
+    return 1;
+  }
+
+  fprintf(file, "// Generated by tools/bake_font.c from res/roboto.h, run build_res.sh to remake it\n\n");
+  fprintf(file, "#define FONT_ATLAS_WIDTH %d\n", atlas.width);
+  fprintf(file, "#define FONT_ATLAS_HEIGHT %d\n", atlas.height);
+  fprintf(file, "#define FONT_ATLAS_GLYPH_AMOUNT %d\n\n", codepointCount);
+
+  fprintf(file, "// Alpha only, deflated\n");
+  fprintf(file, "static const unsigned char FONT_ATLAS_DATA[%d] = {\n", compressedSize);
+  WriteBytes(file, compressed, compressedSize);
+  fprintf(file, "};\n\n");
+
+  fprintf(file, "static const BakedGlyph FONT_ATLAS_GLYPHS[FONT_ATLAS_GLYPH_AMOUNT] = {\n");
+  for (int i = 0; i < codepointCount; i++)
+  {
+    fprintf(file, "  { %d, %d, %d, %d, %d, %d, %d, %d },\n",
+        glyphs[i].value, glyphs[i].offsetX, glyphs[i].offsetY, glyphs[i].advanceX,
+        (int)recs[i].x, (int)recs[i].y, (int)recs[i].width, (int)recs[i].height);
+  }
+  fprintf(file, "};\n");
+
+  fclose(file);
+
+  printf("Baked %d glyphs into a %dx%d atlas, %d bytes compressed\n", codepointCount, atlas.width, atlas.height, compressedSize);
+
+  MemFree(compressed);
+  MemFree(alpha);
+  MemFree(recs);
+  UnloadImage(atlas);
+  UnloadFontData(glyphs, codepointCount);
+  return 0;
+}
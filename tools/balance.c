@@ -0,0 +1,401 @@
+// Plays a load of bot games for every combination of bot and difficulty
+// parameters given on the command line and prints score / length stats
+// for each, one line per parameter set.
+//
+// Example:
+//   csimon-balance --games 1000000 --span 6,8,12 --error 0.01,0.03 --min-rate 0.25,0.3
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "game.h"
+#include "bot.h"
+
+#define MAX_PARAM_VALUES 32
+#define GAMES_PER_TASK 4096
+#define LENGTH_HISTOGRAM_SIZE 1024
+#define SCORE_HISTOGRAM_SIZE 8192
+// A bot that never messes up would otherwise play forever
+#define MAX_GAME_DURATION (60.f * 60.f)
+
+typedef struct ParamList {
+  const char* name;
+  float values[MAX_PARAM_VALUES];
+  int count;
+} ParamList;
+
+enum {
+  PARAM_REACTION,
+  PARAM_SPAN,
+  PARAM_ERROR,
+  PARAM_INITIAL_RATE,
+  PARAM_ACCELERATION,
+  PARAM_DECELERATION,
+  PARAM_MIN_RATE,
+  PARAM_AMOUNT
+};
+
+typedef struct ParamSet {
+  BotParams bot;
+  CsimonDifficulty difficulty;
+} ParamSet;
+
+typedef struct Stats {
+  uint64_t games;
+  uint64_t capped;
+  double totalScore;
+  double totalLength;
+  double totalDuration;
+  int maxLength;
+  uint32_t lengthHistogram[LENGTH_HISTOGRAM_SIZE];
+  uint32_t scoreHistogram[SCORE_HISTOGRAM_SIZE];
+} Stats;
+
+typedef struct SetResult {
+  pthread_mutex_t lock;
+  Stats stats;
+} SetResult;
+
+static ParamList params[PARAM_AMOUNT] = {
+  [PARAM_REACTION]     = { "reaction", { 0.2f }, 1 },
+  [PARAM_SPAN]         = { "span", { 8 }, 1 },
+  [PARAM_ERROR]        = { "error", { 0.02f }, 1 },
+  [PARAM_INITIAL_RATE] = { "initial-rate", { INITIAL_SEQUENCE_DISPLAY_RATE }, 1 },
+  [PARAM_ACCELERATION] = { "acceleration", { SEQUENCE_DISPLAY_RATE_ACCELERATION }, 1 },
+  [PARAM_DECELERATION] = { "deceleration", { SEQUENCE_DISPLAY_RATE_ACCELERATION_DECCELERATION }, 1 },
+  [PARAM_MIN_RATE]     = { "min-rate", { MIN_SEQUENCE_DISPLAY_RATE }, 1 },
+};
+
+static ParamSet* sets;
+static SetResult* results;
+static int setCount;
+
+static uint64_t gamesPerSet = 100000;
+static uint64_t baseSeed = 1;
+static float tickDuration = 1.f / 60.f;
+static bool marathon = false;
+
+static uint64_t taskCount;
+static uint64_t tasksPerSet;
+static atomic_uint_fast64_t nextTask;
+
+static void Usage(const char* name)
+{
+  fprintf(stderr,
+      "Usage: %s [options]\n"
+      "  --games N        Games per parameter set (default 100000)\n"
+      "  --threads N      Worker threads (default: every core)\n"
+      "  --tick-rate HZ   Simulation tick rate (default 60, same as the game)\n"
+      "  --seed N         Base seed\n"
+      "  --marathon       No length cap, otherwise games reaching the classic cap count as capped\n"
+      "Comma separated lists, every combination gets played:\n"
+      "  --reaction S     Bot seconds between presses\n"
+      "  --span N         Bot memory span in steps\n"
+      "  --error P        Bot chance of a wrong press\n"
+      "  --initial-rate S --acceleration S --deceleration S --min-rate S\n"
+      "                   Difficulty curve, defaults match the game\n",
+      name);
+}
+
+static bool ParseList(ParamList* list, const char* text)
+{
+  list->count = 0;
+  while (*text)
+  {
+    if (list->count >= MAX_PARAM_VALUES)
+      return false;
+
+    char* end;
+    list->values[list->count++] = strtof(text, &end);
+    if (end == text)
+      return false;
+
+    text = (*end == ',') ? end + 1 : end;
+  }
+  return list->count > 0;
+}
+
+static uint64_t MixSeed(uint64_t x)
+{
+  x ^= x >> 33;
+  x *= 0xff51afd7ed558ccdULL;
+  x ^= x >> 33;
+  x *= 0xc4ceb9fe1a85ec53ULL;
+  x ^= x >> 33;
+  return x;
+}
+
+static void PlayGame(const ParamSet* set, uint64_t seed, Stats* stats)
+{
+  CsimonGame game = { 0 };
+  CsimonInit(&game);
+  game.difficulty = set->difficulty;
+  game.marathon = marathon;
+  CsimonSeed(&game, seed);
+  CsimonReset(&game);
+
+  Bot bot;
+  BotInit(&bot, set->bot, ~seed);
+
+  int score = 0;
+  int length = 1;
+  float duration = 0.f;
+  bool capped = false;
+
+  while (true)
+  {
+    CsimonInput input = BotThink(&bot, &game, tickDuration);
+    CsimonStep(&game, &input, tickDuration);
+    duration += tickDuration;
+
+    if (game.runsFinished > 0)
+    {
+      score = game.lastScore;
+      length = game.lastLength;
+      capped = game.animationType == ANIMATION_TYPE_WIN;
+      break;
+    }
+
+    if (duration > MAX_GAME_DURATION)
+    {
+      score = game.score;
+      length = game.sequenceLength;
+      capped = true;
+      break;
+    }
+  }
+
+  stats->games++;
+  stats->capped += capped;
+  stats->totalScore += score;
+  stats->totalLength += length;
+  stats->totalDuration += duration;
+  if (length > stats->maxLength) stats->maxLength = length;
+  stats->lengthHistogram[length < LENGTH_HISTOGRAM_SIZE ? length : LENGTH_HISTOGRAM_SIZE-1]++;
+  stats->scoreHistogram[score < SCORE_HISTOGRAM_SIZE ? score : SCORE_HISTOGRAM_SIZE-1]++;
+}
+
+static void MergeStats(Stats* into, const Stats* from)
+{
+  into->games += from->games;
+  into->capped += from->capped;
+  into->totalScore += from->totalScore;
+  into->totalLength += from->totalLength;
+  into->totalDuration += from->totalDuration;
+  if (from->maxLength > into->maxLength) into->maxLength = from->maxLength;
+  for (size_t i = 0; i < LENGTH_HISTOGRAM_SIZE; i++)
+    into->lengthHistogram[i] += from->lengthHistogram[i];
+  for (size_t i = 0; i < SCORE_HISTOGRAM_SIZE; i++)
+    into->scoreHistogram[i] += from->scoreHistogram[i];
+}
+
+// arg is the thread's own Stats to count each task into before merging, allocated up front
+// so a worker can't fail after it's started taking tasks
+static void* Worker(void* arg)
+{
+  Stats* local = arg;
+
+  while (true)
+  {
+    uint64_t task = atomic_fetch_add(&nextTask, 1);
+    if (task >= taskCount)
+      break;
+
+    int setIndex = (int)(task / tasksPerSet);
+    uint64_t first = (task % tasksPerSet) * GAMES_PER_TASK;
+    uint64_t last = first + GAMES_PER_TASK;
+    if (last > gamesPerSet) last = gamesPerSet;
+
+    memset(local, 0, sizeof(Stats));
+    for (uint64_t i = first; i < last; i++)
+    {
+      PlayGame(&sets[setIndex], MixSeed(baseSeed ^ ((uint64_t)setIndex << 40) ^ i), local);
+    }
+
+    pthread_mutex_lock(&results[setIndex].lock);
+    MergeStats(&results[setIndex].stats, local);
+    pthread_mutex_unlock(&results[setIndex].lock);
+  }
+
+  return NULL;
+}
+
+static int Percentile(const uint32_t* histogram, int size, uint64_t total, double p)
+{
+  uint64_t target = (uint64_t)(total * p);
+  uint64_t seen = 0;
+  for (int i = 0; i < size; i++)
+  {
+    seen += histogram[i];
+    if (seen > target)
+      return i;
+  }
+  return size - 1;
+}
+
+static void BuildSets()
+{
+  setCount = 1;
+  for (int i = 0; i < PARAM_AMOUNT; i++)
+    setCount *= params[i].count;
+
+  sets = calloc(setCount, sizeof(ParamSet));
+  results = calloc(setCount, sizeof(SetResult));
+  if (sets == NULL || results == NULL)
+  {
+    perror("Could not allocate parameter sets");
+    exit(1);
+  }
+
+  for (int s = 0; s < setCount; s++)
+  {
+    float v[PARAM_AMOUNT];
+    int rest = s;
+    for (int i = PARAM_AMOUNT - 1; i >= 0; i--)
+    {
+      v[i] = params[i].values[rest % params[i].count];
+      rest /= params[i].count;
+    }
+
+    sets[s].bot.reactionTime = v[PARAM_REACTION];
+    sets[s].bot.memorySpan = (int)v[PARAM_SPAN];
+    sets[s].bot.errorRate = v[PARAM_ERROR];
+    sets[s].difficulty.initialDisplayRate = v[PARAM_INITIAL_RATE];
+    sets[s].difficulty.displayRateAcceleration = v[PARAM_ACCELERATION];
+    sets[s].difficulty.displayRateAccelerationDecceleration = v[PARAM_DECELERATION];
+    sets[s].difficulty.minDisplayRate = v[PARAM_MIN_RATE];
+
+    pthread_mutex_init(&results[s].lock, NULL);
+  }
+}
+
+static void PrintResults()
+{
+  printf("reaction,span,error,initial_rate,acceleration,deceleration,min_rate,"
+         "games,capped,mean_score,p50_score,p90_score,p99_score,"
+         "mean_length,p50_length,p90_length,p99_length,max_length,mean_duration\n");
+
+  for (int s = 0; s < setCount; s++)
+  {
+    const ParamSet* set = &sets[s];
+    const Stats* stats = &results[s].stats;
+    double games = stats->games ? (double)stats->games : 1.0;
+
+    printf("%g,%d,%g,%g,%g,%g,%g,%llu,%llu,%.2f,%d,%d,%d,%.2f,%d,%d,%d,%d,%.2f\n",
+        set->bot.reactionTime, set->bot.memorySpan, set->bot.errorRate,
+        set->difficulty.initialDisplayRate, set->difficulty.displayRateAcceleration,
+        set->difficulty.displayRateAccelerationDecceleration, set->difficulty.minDisplayRate,
+        (unsigned long long)stats->games, (unsigned long long)stats->capped,
+        stats->totalScore / games,
+        Percentile(stats->scoreHistogram, SCORE_HISTOGRAM_SIZE, stats->games, 0.5),
+        Percentile(stats->scoreHistogram, SCORE_HISTOGRAM_SIZE, stats->games, 0.9),
+        Percentile(stats->scoreHistogram, SCORE_HISTOGRAM_SIZE, stats->games, 0.99),
+        stats->totalLength / games,
+        Percentile(stats->lengthHistogram, LENGTH_HISTOGRAM_SIZE, stats->games, 0.5),
+        Percentile(stats->lengthHistogram, LENGTH_HISTOGRAM_SIZE, stats->games, 0.9),
+        Percentile(stats->lengthHistogram, LENGTH_HISTOGRAM_SIZE, stats->games, 0.99),
+        stats->maxLength,
+        stats->totalDuration / games);
+  }
+}
+
+int main(int argc, char** argv)
+{
+  long threadCount = sysconf(_SC_NPROCESSORS_ONLN);
+
+  for (int i = 1; i < argc; i++)
+  {
+    const char* arg = argv[i];
+    const char* value = (i + 1 < argc) ? argv[i + 1] : NULL;
+    bool parsed = false;
+
+    if (strcmp(arg, "--marathon") == 0)
+    {
+      marathon = true;
+      continue;
+    }
+
+    if (value == NULL)
+    {
+      Usage(argv[0]);
+      return 1;
+    }
+
+    if (strcmp(arg, "--games") == 0)
+    {
+      gamesPerSet = strtoull(value, NULL, 10);
+      parsed = gamesPerSet > 0;
+    } else if (strcmp(arg, "--threads") == 0)
+    {
+      threadCount = strtol(value, NULL, 10);
+      parsed = threadCount > 0;
+    } else if (strcmp(arg, "--tick-rate") == 0)
+    {
+      float rate = strtof(value, NULL);
+      tickDuration = 1.f / rate;
+      parsed = rate > 0.f;
+    } else if (strcmp(arg, "--seed") == 0)
+    {
+      baseSeed = strtoull(value, NULL, 10);
+      parsed = true;
+    } else if (strncmp(arg, "--", 2) == 0)
+    {
+      for (int p = 0; p < PARAM_AMOUNT; p++)
+      {
+        if (strcmp(arg + 2, params[p].name) == 0)
+          parsed = ParseList(&params[p], value);
+      }
+    }
+
+    if (!parsed)
+    {
+      fprintf(stderr, "Bad argument %s %s\n", arg, value);
+      Usage(argv[0]);
+      return 1;
+    }
+    i++;
+  }
+  if (threadCount < 1) threadCount = 1;
+
+  BuildSets();
+
+  tasksPerSet = (gamesPerSet + GAMES_PER_TASK - 1) / GAMES_PER_TASK;
+  taskCount = tasksPerSet * setCount;
+  atomic_init(&nextTask, 0);
+
+  fprintf(stderr, "Playing %llu games for %d parameter sets on %ld threads\n",
+      (unsigned long long)gamesPerSet, setCount, threadCount);
+
+  pthread_t* threads = calloc(threadCount, sizeof(pthread_t));
+  Stats* threadStats = calloc(threadCount, sizeof(Stats));
+  if (threads == NULL || threadStats == NULL)
+  {
+    perror("Could not allocate threads");
+    return 1;
+  }
+  for (long i = 0; i < threadCount; i++)
+  {
+    if (pthread_create(&threads[i], NULL, Worker, &threadStats[i]) != 0)
+    {
+      perror("Could not start worker thread");
+      return 1;
+    }
+  }
+  for (long i = 0; i < threadCount; i++)
+  {
+    pthread_join(threads[i], NULL);
+  }
+
+  PrintResults();
+
+  free(threads);
+  free(threadStats);
+  free(sets);
+  free(results);
+  return 0;
+}
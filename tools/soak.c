@@ -0,0 +1,292 @@
+// Runs the game logic headless through weeks of simulated uptime, the way a cabinet
+// spends it: long stretches sitting in the menu, now and then someone (the bot) playing
+// a few runs. Every tick is stepped, just as fast as the CPU goes. Checks that
+//  - the game clocks count exactly the time they were given, however long it's been up
+//  - the title blink, sequence playback and game over animation take as long in the
+//    last week as in the first, and playback keeps the original tempo
+//  - nothing gets stuck, something always changes within STALL_TIME of a run going
+//  - memory doesn't grow
+// and exits with 1 if any of it goes wrong.
+//
+// Example:
+//   csimon-soak --days 90 --tick-rate 60
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <sys/resource.h>
+
+#include "game.h"
+#include "bot.h"
+
+#define SECONDS_PER_DAY (24ull * 60 * 60)
+#define STALL_TIME (60ull * CSIMON_US_PER_SECOND)
+// Memory the process can pick up after the first day without it counting as a leak
+#define RSS_SLACK_KB 256
+
+static uint64_t days = 30;
+static uint64_t tickRate = 60;
+static uint64_t seed = 1;
+static uint64_t idleMinutes = 30;
+static int runsPerSession = 3;
+
+static uint64_t tickUs;
+static float tickDt;
+static uint64_t simulatedUs = 0;
+static int failures = 0;
+
+static CsimonGame game;
+static Bot bot;
+static CsimonRng rng;
+
+// Whatever the first measurement of each was, later ones have to match it
+static int64_t gameoverTicks = -1;
+static int64_t titleLitTicks = -1;
+static long baseRss = -1;
+
+typedef struct WeekStats {
+  uint64_t runs;
+  int bestScore;
+  uint64_t sequences;
+  int64_t worstSequenceError; // Ticks, against CsimonSequenceDuration
+} WeekStats;
+
+static WeekStats week;
+
+static void Usage(const char* name)
+{
+  fprintf(stderr,
+      "Usage: %s [options]\n"
+      "  --days N          Simulated uptime (default 30)\n"
+      "  --tick-rate HZ    Simulation tick rate (default 60, same as the game)\n"
+      "  --seed N          Seed for the game, the bot and the idle times\n"
+      "  --idle-minutes N  Average time in the menu between players (default 30)\n"
+      "  --runs N          Runs each player plays (default 3)\n",
+      name);
+}
+
+static void Fail(const char* what)
+{
+  double day = (double)simulatedUs / 1e6 / SECONDS_PER_DAY;
+  printf("FAIL day %.3f: %s\n", day, what);
+  failures++;
+}
+
+static long MaxRssKb(void)
+{
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0)
+    return -1;
+  return usage.ru_maxrss;
+}
+
+// The original tempo, written out here rather than taken from the game's timeline. The old
+// per frame accumulator never reset isWaitingBetweenButton between rounds, so after the first
+// round every sequence started with a full lit time of dark, then each button was off for a
+// third of that and lit, ending the moment the last one went off
+static uint64_t ExpectedSequenceDuration(const CsimonGame* game)
+{
+  uint64_t lit = CsimonSequenceLitTime(game);
+  return lit + (uint64_t)game->sequenceLength * (lit + lit / 3);
+}
+
+static void Step(const CsimonInput* input)
+{
+  CsimonStep(&game, input, tickDt);
+  simulatedUs += tickUs;
+}
+
+// Sits in the menu with nobody touching anything, the clocks have to move by exactly
+// what they were given, and the title blink (same sum as main.c) can't change its rhythm
+static void Idle(uint64_t ticks)
+{
+  CsimonInput input = CsimonEmptyInput();
+  uint64_t runTime = game.runTime;
+  uint64_t menuTime = game.menuTime;
+
+  for (uint64_t i = 0; i < ticks; i++)
+  {
+    Step(&input);
+  }
+
+  if (game.runTime - runTime != ticks * tickUs || game.menuTime - menuTime != ticks * tickUs)
+    Fail("game clocks drifted from the time they were stepped by");
+
+  // One second of blinking
+  int64_t lit = 0;
+  for (uint64_t i = 0; i < tickRate; i++)
+  {
+    Step(&input);
+    lit += (game.runTime * 15 / CSIMON_US_PER_SECOND) % 15 > 7;
+  }
+  if (titleLitTicks < 0)
+    titleLitTicks = lit;
+  else if (lit < titleLitTicks - 1 || lit > titleLitTicks + 1)
+    Fail("title blink changed rhythm");
+}
+
+// The bot plays until it's finished its runs, watching for anything getting stuck
+static void Play(int runs)
+{
+  unsigned int runsFinished = game.runsFinished + (unsigned int)runs;
+  uint64_t lastChange = simulatedUs;
+  int lastState = game.gameState;
+  int lastIndex = game.playerSequenceIndex;
+  int lastDisplayIndex = game.sequenceDisplayIndex;
+
+  int64_t sequenceTicks = 0;
+  uint64_t sequenceDuration = 0;
+  uint64_t runEnd = 0;
+  bool endingRun = false;
+
+  while (game.runsFinished < runsFinished || endingRun)
+  {
+    CsimonInput input = BotThink(&bot, &game, tickDt);
+    // Ticks the sequence gets stepped for, against how long its timeline says it is
+    if (game.gameState == GAMESTATE_GAME && game.isShowingSequence)
+    {
+      if (sequenceTicks++ == 0)
+      {
+        sequenceDuration = CsimonSequenceDuration(&game);
+        if (sequenceDuration != ExpectedSequenceDuration(&game))
+          Fail("sequence timeline changed tempo");
+      }
+    }
+
+    unsigned int finishedBefore = game.runsFinished;
+    Step(&input);
+
+    if (sequenceTicks > 0 && !game.isShowingSequence)
+    {
+      int64_t error = sequenceTicks - (int64_t)((sequenceDuration + tickUs - 1) / tickUs);
+      if (error < 0) error = -error;
+      if (error > week.worstSequenceError) week.worstSequenceError = error;
+      if (error > 1) Fail("sequence playback took the wrong amount of time");
+      week.sequences++;
+      sequenceTicks = 0;
+    }
+
+    if (game.runsFinished != finishedBefore)
+    {
+      week.runs++;
+      if (game.lastScore > week.bestScore) week.bestScore = game.lastScore;
+      runEnd = simulatedUs;
+      endingRun = true;
+    }
+
+    // From the run ending to the game over title
+    if (endingRun && game.gameState == GAMESTATE_MENU_GAMEOVER)
+    {
+      int64_t ticks = (int64_t)((simulatedUs - runEnd) / tickUs);
+      if (gameoverTicks < 0)
+        gameoverTicks = ticks;
+      else if (ticks != gameoverTicks)
+        Fail("game over animation changed length");
+      endingRun = false;
+    }
+
+    if (game.gameState != lastState || game.playerSequenceIndex != lastIndex || game.sequenceDisplayIndex != lastDisplayIndex)
+    {
+      lastState = game.gameState;
+      lastIndex = game.playerSequenceIndex;
+      lastDisplayIndex = game.sequenceDisplayIndex;
+      lastChange = simulatedUs;
+    } else if (simulatedUs - lastChange > STALL_TIME && game.gameState != GAMESTATE_MENU && game.gameState != GAMESTATE_MENU_GAMEOVER)
+    {
+      Fail("game stopped moving");
+      return;
+    }
+  }
+}
+
+static void EndWeek(uint64_t number)
+{
+  long rss = MaxRssKb();
+  printf("week %3llu: %6llu runs  best %5d  %7llu sequences (worst %lld ticks off)  game over %lld ticks  title lit %lld/%llu  max rss %ld KB\n",
+      (unsigned long long)number, (unsigned long long)week.runs, week.bestScore,
+      (unsigned long long)week.sequences, (long long)week.worstSequenceError,
+      (long long)gameoverTicks, (long long)titleLitTicks, (unsigned long long)tickRate, rss);
+  fflush(stdout);
+  memset(&week, 0, sizeof(week));
+}
+
+int main(int argc, char** argv)
+{
+  for (int i = 1; i < argc; i++)
+  {
+    const char* arg = argv[i];
+    const char* value = (i + 1 < argc) ? argv[i + 1] : NULL;
+    if (value == NULL)
+    {
+      Usage(argv[0]);
+      return 1;
+    }
+
+    bool parsed = true;
+    if (strcmp(arg, "--days") == 0)
+      days = strtoull(value, NULL, 10);
+    else if (strcmp(arg, "--tick-rate") == 0)
+      parsed = (tickRate = strtoull(value, NULL, 10)) > 0;
+    else if (strcmp(arg, "--seed") == 0)
+      seed = strtoull(value, NULL, 10);
+    else if (strcmp(arg, "--idle-minutes") == 0)
+      idleMinutes = strtoull(value, NULL, 10);
+    else if (strcmp(arg, "--runs") == 0)
+      parsed = (runsPerSession = atoi(value)) > 0;
+    else
+      parsed = false;
+
+    if (!parsed)
+    {
+      fprintf(stderr, "Bad argument %s %s\n", arg, value);
+      Usage(argv[0]);
+      return 1;
+    }
+    i++;
+  }
+
+  // Whole microseconds like the game steps with
+  tickUs = (CSIMON_US_PER_SECOND + tickRate / 2) / tickRate;
+  tickDt = (float)tickUs / 1e6f;
+
+  CsimonInit(&game);
+  CsimonSeed(&game, seed);
+  CsimonReset(&game);
+  BotInit(&bot, (BotParams){ 0.3f, 10, 0.03f }, ~seed);
+  CsimonRngSeed(&rng, seed ^ 0x50a4);
+
+  printf("Soaking %llu days at %llu Hz, a player every ~%llu minutes\n",
+      (unsigned long long)days, (unsigned long long)tickRate, (unsigned long long)idleMinutes);
+
+  uint64_t end = days * SECONDS_PER_DAY * CSIMON_US_PER_SECOND;
+  uint64_t weekUs = 7 * SECONDS_PER_DAY * CSIMON_US_PER_SECOND;
+  uint64_t nextWeek = weekUs;
+  uint64_t weekNumber = 1;
+
+  while (simulatedUs < end && failures == 0)
+  {
+    // Anywhere from no time at all to twice the average
+    uint64_t idleUs = (uint64_t)(CsimonRngFloat(&rng) * 2.f * (float)idleMinutes * 60.f) * CSIMON_US_PER_SECOND;
+    Idle(idleUs / tickUs);
+    Play(runsPerSession);
+
+    if (baseRss < 0 && simulatedUs >= SECONDS_PER_DAY * CSIMON_US_PER_SECOND)
+      baseRss = MaxRssKb();
+
+    if (simulatedUs >= nextWeek)
+    {
+      EndWeek(weekNumber++);
+      nextWeek += weekUs;
+    }
+  }
+  if (week.runs > 0)
+    EndWeek(weekNumber);
+
+  if (baseRss >= 0 && MaxRssKb() > baseRss + RSS_SLACK_KB)
+    Fail("memory grew after the first day");
+
+  printf("%s after %.1f simulated days\n", failures ? "FAILED" : "OK", (double)simulatedUs / 1e6 / SECONDS_PER_DAY);
+  return failures ? 1 : 0;
+}
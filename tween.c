@@ -0,0 +1,62 @@
+#include "tween.h"
+
+#include <math.h>
+
+int TweenAdd(TweenSet* set, int curve, float rate, float value)
+{
+  if (set->count >= TWEEN_MAX)
+    return -1;
+
+  int index = set->count++;
+  set->curve[index] = curve;
+  set->rate[index] = rate;
+  set->value[index] = value;
+  set->target[index] = value;
+  set->velocity[index] = 0.f;
+  return index;
+}
+
+void TweenStep(TweenSet* set, float dt)
+{
+  // Both curves are solved exactly for the step, so one long step lands
+  // where many short ones would
+  for (int i = 0; i < set->count; i++)
+  {
+    float offset = set->value[i] - set->target[i];
+    float decay = expf(-set->rate[i] * dt);
+
+    if (set->curve[i] == TWEEN_SPRING)
+    {
+      float push = (set->velocity[i] + set->rate[i] * offset) * dt;
+      set->velocity[i] = (set->velocity[i] - set->rate[i] * push) * decay;
+      offset = (offset + push) * decay;
+    } else
+    {
+      offset *= decay;
+    }
+
+    set->value[i] = set->target[i] + offset;
+  }
+}
+
+bool TweenSettle(TweenSet* set, float epsilon)
+{
+  bool settled = true;
+  for (int i = 0; i < set->count; i++)
+  {
+    if (fabsf(set->value[i] - set->target[i]) < epsilon && fabsf(set->velocity[i]) < epsilon)
+    {
+      set->value[i] = set->target[i];
+      set->velocity[i] = 0.f;
+    } else
+    {
+      settled = false;
+    }
+  }
+  return settled;
+}
+
+float TweenRateFromLerp(float t, float fps)
+{
+  return -logf(1.f - t) * fps;
+}
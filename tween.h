@@ -0,0 +1,34 @@
+#ifndef CSIMON_TWEEN_H
+#define CSIMON_TWEEN_H
+
+#include <stdbool.h>
+
+// Animated values that chase a target, stepped with the real frame time so they
+// look the same at any frame rate. Everything lives in flat arrays and gets
+// stepped in one go, no raylib needed.
+
+#define TWEEN_MAX 32
+
+enum {
+  TWEEN_EXPONENTIAL, // Covers the same fraction of the gap every second, rate is 1/s
+  TWEEN_SPRING       // Critically damped spring, rate is the angular frequency (1/s)
+};
+
+typedef struct TweenSet {
+  int count;
+  int curve[TWEEN_MAX];
+  float rate[TWEEN_MAX];
+  float value[TWEEN_MAX];
+  float target[TWEEN_MAX];
+  float velocity[TWEEN_MAX];
+} TweenSet;
+
+// Returns the index of the new value, -1 when the set is full
+int TweenAdd(TweenSet* set, int curve, float rate, float value);
+void TweenStep(TweenSet* set, float dt);
+// Puts anything within epsilon of its target right on it, true once nothing is moving anymore
+bool TweenSettle(TweenSet* set, float epsilon);
+// Rate that matches lerping by t once a frame at fps, for porting per frame lerps
+float TweenRateFromLerp(float t, float fps);
+
+#endif